@@ -1,9 +1,14 @@
-
 #include "forward.hpp"
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include <atomic>
 #include "result.hpp"
 #include "panic.hpp"
+#include "stddef.hpp"
+#include "hash.hpp"
+#include "epoch.hpp"
 
 _STD_API_BEGIN
 
@@ -11,6 +16,113 @@ enum class EnvironmentError {
     VariableDoesNotExist,
 };
 
+/// <summary>
+/// An immutable copy of the process environment, indexed by an open addressing hash table.
+/// Every key and value lives in one contiguous buffer, so lookups hand out string_views
+/// into the snapshot and never allocate.
+/// </summary>
+class EnvironmentSnapshot {
+private:
+    struct _Slot {
+        uint64 hash;
+        uint32 key_offset, key_length;
+        uint32 value_offset, value_length;
+    };
+
+    std::string _Blob;
+    std::vector<_Slot> _Slots;
+    size_t _Mask{ 0 };
+    size_t _Count{ 0 };
+public:
+    EnvironmentSnapshot(const EnvironmentSnapshot&) = delete;
+    EnvironmentSnapshot& operator=(const EnvironmentSnapshot&) = delete;
+
+    inline explicit EnvironmentSnapshot(char** env) noexcept {
+        size_t _Entries = 0;
+        size_t _Bytes = 0;
+        for (auto** ptr = env; ptr && *ptr; ++ptr) {
+            _Bytes += std::char_traits<char>::length(*ptr);
+            ++_Entries;
+        }
+
+        // keep the load factor at or under 50% so probe chains stay short.
+        size_t _Capacity = 16;
+        while (_Capacity < _Entries * 2)
+            _Capacity <<= 1;
+        _Slots.assign(_Capacity, _Slot{});
+        _Mask = _Capacity - 1;
+        _Blob.reserve(_Bytes);
+
+        for (auto** ptr = env; ptr && *ptr; ++ptr) {
+            const auto _Entry = std::string_view(*ptr);
+            // Windows keeps per-drive entries like "=C:=C:\\", the first '=' is part of the name.
+            const auto _Equals = _Entry.find('=', 1);
+            if (_Equals == std::string_view::npos)
+                continue;
+
+            const auto _Key = _Entry.substr(0, _Equals);
+            const auto _Value = _Entry.substr(_Equals + 1);
+            const auto _Hash = hash_string(_Key);
+
+            auto* _Target = _Probe(_Key, _Hash);
+            if (_Target->key_length != 0)
+                // duplicate names, the first one wins (same as getenv).
+                continue;
+
+            _Target->hash = _Hash;
+            _Target->key_offset = static_cast<uint32>(_Blob.size());
+            _Target->key_length = static_cast<uint32>(_Key.size());
+            _Blob.append(_Key);
+            _Target->value_offset = static_cast<uint32>(_Blob.size());
+            _Target->value_length = static_cast<uint32>(_Value.size());
+            _Blob.append(_Value);
+            ++_Count;
+        }
+    }
+
+    _NODISCARD inline Result<std::string_view, EnvironmentError> get(std::string_view key) const noexcept {
+        const auto* _Slot = _Probe(key, hash_string(key));
+        if (_Slot->key_length == 0)
+            return EnvironmentError::VariableDoesNotExist;
+        return std::string_view(_Blob.data() + _Slot->value_offset, _Slot->value_length);
+    }
+
+    _NODISCARD inline bool contains(std::string_view key) const noexcept {
+        return _Probe(key, hash_string(key))->key_length != 0;
+    }
+
+    _NODISCARD inline size_t size() const noexcept {
+        return _Count;
+    }
+
+    // Calls fn(key, value) for every variable, in no particular order.
+    template <class Fn>
+    inline void for_each(Fn&& fn) const {
+        for (const auto& slot : _Slots) {
+            if (slot.key_length == 0)
+                continue;
+            fn(std::string_view(_Blob.data() + slot.key_offset, slot.key_length),
+               std::string_view(_Blob.data() + slot.value_offset, slot.value_length));
+        }
+    }
+
+private:
+    // Either the slot holding key, or the empty slot where it would go.
+    inline _Slot* _Probe(std::string_view key, uint64 hash) noexcept {
+        return const_cast<_Slot*>(std::as_const(*this)._Probe(key, hash));
+    }
+    inline const _Slot* _Probe(std::string_view key, uint64 hash) const noexcept {
+        for (size_t index = hash & _Mask;; index = (index + 1) & _Mask) {
+            const auto& _This_slot = _Slots[index];
+            if (_This_slot.key_length == 0)
+                return &_This_slot;
+            if (_This_slot.hash == hash
+                && std::string_view(_Blob.data() + _This_slot.key_offset, _This_slot.key_length) == key)
+                return &_This_slot;
+        }
+    }
+};
+
 /// STATIC class
 class Environment {
 public:
@@ -30,21 +142,57 @@ public:
         panic(ALWAYS(), "This platform is not yet supported for SETTING environment variables.");
     }
 
+    /// <summary>
+    /// Lock-free, allocation free lookup against the current snapshot. The view points into
+    /// that snapshot and stays valid for as long as `guard`, a Guard on reclamation_domain(),
+    /// is held:
+    ///
+    ///     stud::EpochDomain::Guard guard(Environment::reclamation_domain());
+    ///     auto home = Environment::lookup("HOME", guard);
+    ///
+    /// Changes made to the environment are not visible until refresh() is called.
+    /// </summary>
+    static Result<std::string_view, EnvironmentError> lookup(std::string_view varName, const EpochDomain::Guard& guard) noexcept {
+        return snapshot(guard).get(varName);
+    }
+
+    // The current snapshot, valid for as long as `guard` is held (see lookup()).
+    static const EnvironmentSnapshot& snapshot(const EpochDomain::Guard& guard) noexcept {
+        panic(IF(&guard.domain() != &reclamation_domain()), "Environment::snapshot(): the Guard must be on Environment::reclamation_domain().");
+        auto* _Current = _Current_snapshot().load(std::memory_order_acquire);
+        if (_Current) [[likely]]
+            return *_Current;
+        refresh();
+        return *_Current_snapshot().load(std::memory_order_acquire);
+    }
+
+    /// <summary>
+    /// Re-read the process environment and publish it as the new snapshot. The previous one
+    /// is retired to reclamation_domain() and freed once no Guard that could have read it is
+    /// still held, so reloading on every change does not grow memory.
+    /// </summary>
+    static void refresh() noexcept {
+        auto* _Fresh = new EnvironmentSnapshot(environ);
+        auto* _Previous = _Current_snapshot().exchange(_Fresh, std::memory_order_acq_rel);
+        if (_Previous) {
+            EpochDomain::Guard _Guard(reclamation_domain());
+            _Guard.retire(_Previous);
+        }
+        reclamation_domain().collect();
+    }
+
+    // Keeps snapshots from being freed while a Guard on it is held, see lookup().
+    static EpochDomain& reclamation_domain() noexcept {
+        static EpochDomain _Domain;
+        return _Domain;
+    }
+
     static const EnvData& data() noexcept {
-        static EnvData _Static_data = {};
-
-        if (_Static_data.size() == 0) {
-            auto** env_ptr = environ;
-            auto original_ptr = env_ptr;
-            std::size_t length = 0;
-            while (*(env_ptr++) != NULL)
-                ++length;
-
-            // Populate the vector.
-            for (std::size_t i = 0; i < length; ++i)
-            {
-                auto* this_item = original_ptr[i];
-                auto environment_str = std::string(this_item);
+        // function local statics are initialized exactly once, even when raced.
+        static const EnvData _Static_data = []() {
+            EnvData _Data = {};
+            for (auto** env_ptr = environ; *env_ptr != NULL; ++env_ptr) {
+                auto environment_str = std::string(*env_ptr);
                 size_t pos_of_equals = environment_str.find('=');
 
                 if (pos_of_equals == std::string::npos)
@@ -54,12 +202,19 @@ public:
                 auto key = environment_str.substr(0, pos_of_equals);
                 auto value = environment_str.substr(pos_of_equals + 1);
 
-                _Static_data.push_back(std::make_pair(key, value));
+                _Data.push_back(std::make_pair(key, value));
             }
-        }
+            return _Data;
+        }();
 
         return _Static_data;
     }
+
+private:
+    static std::atomic<const EnvironmentSnapshot*>& _Current_snapshot() noexcept {
+        static std::atomic<const EnvironmentSnapshot*> _Current{ nullptr };
+        return _Current;
+    }
 };
 
-_STD_API_END
\ No newline at end of file
+_STD_API_END
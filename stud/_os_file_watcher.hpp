@@ -0,0 +1,431 @@
+#include "forward.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <atomic>
+#include <chrono>
+
+#include "result.hpp"
+#include "panic.hpp"
+#include "stddef.hpp"
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <climits>
+#include <cerrno>
+#endif
+
+_STD_API_BEGIN
+
+#if defined(__linux__)
+
+enum class FileWatcherError {
+    InitFailed,
+    WatchFailed,
+    NotWatched,
+};
+
+// What happened to a path. Several kinds can be merged into one
+// notification when events arrive inside the same coalescing window.
+enum FileChangeKind : uint32 {
+    FileChange_Modified = 0x1,
+    FileChange_Created = 0x2,
+    FileChange_Removed = 0x4,
+    FileChange_Attributes = 0x8,
+    // The kernel queue overflowed, events for this path may have been lost.
+    FileChange_Overflow = 0x10,
+};
+
+struct FileChange {
+    std::string path;
+    uint32 kinds;
+
+    _NODISCARD bool has(FileChangeKind kind) const noexcept {
+        return (kinds & kind) != 0;
+    }
+};
+
+/// <summary>
+/// Event driven file change detection backed by inotify.
+///
+/// One thread reads the inotify descriptor and merges bursts of events per path
+/// (an editor saving a file usually produces several), once a path has been quiet
+/// for the coalescing window a single FileChange is handed to a worker thread which
+/// runs the callbacks. Callbacks never run on the event thread, so a slow reload cannot
+/// cause the kernel queue to overflow.
+///
+/// Files are watched through their parent directory, this keeps the watch alive when a
+/// file is replaced by rename (which is how most editors and config deployers write).
+/// </summary>
+class FileWatcher {
+public:
+    using Callback = std::function<void(const FileChange&)>;
+    using WatchId = size_t;
+    using Clock = std::chrono::steady_clock;
+private:
+    struct _Subscription {
+        WatchId id;
+        // empty when the whole directory is watched.
+        std::string name;
+        Callback callback;
+    };
+    struct _Watched_dir {
+        std::string path;
+        std::vector<_Subscription> subs;
+    };
+    struct _Pending {
+        int wd;
+        std::string name;
+        uint32 kinds;
+        Clock::time_point first_seen;
+        Clock::time_point last_seen;
+    };
+    struct _Job {
+        Callback callback;
+        FileChange change;
+    };
+    // The worker's queue. The worker thread holds its own reference so it never touches
+    // the watcher itself, which lets a callback stop or destroy the watcher it runs on.
+    struct _Worker_state {
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::vector<_Job> jobs;
+        bool stopping{ false };
+        // set when a callback stopped the watcher, the rest of its batch is dropped.
+        std::atomic<bool> abandoned{ false };
+    };
+
+    static constexpr uint32 _Inotify_mask = IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE
+        | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF;
+
+    int _Inotify{ -1 };
+    int _Wake[2]{ -1, -1 };
+    std::chrono::milliseconds _Coalesce;
+
+    std::mutex _Watch_mtx;
+    std::unordered_map<int, _Watched_dir> _Dirs;
+    WatchId _Next_id{ 1 };
+
+    // only touched by the event thread.
+    std::unordered_map<std::string, _Pending> _Pending_changes;
+
+    std::shared_ptr<_Worker_state> _Work{ std::make_shared<_Worker_state>() };
+
+    std::atomic<bool> _Running{ false };
+    std::thread _Event_thread;
+    std::thread _Worker_thread;
+public:
+    _STD_MAKE_NONCOPYABLE(FileWatcher);
+    _STD_MAKE_NONMOVEABLE(FileWatcher);
+
+    inline explicit FileWatcher(std::chrono::milliseconds coalesce = std::chrono::milliseconds(50)) noexcept
+        : _Coalesce(coalesce)
+    {
+        _Inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (_Inotify < 0)
+            return;
+        if (pipe2(_Wake, O_NONBLOCK | O_CLOEXEC) != 0) {
+            ::close(_Inotify);
+            _Inotify = -1;
+            return;
+        }
+
+        _Running.store(true, std::memory_order_release);
+        _Event_thread = std::thread([this]() { _Event_loop(); });
+        _Worker_thread = std::thread([work = _Work]() { _Worker_loop(work); });
+    }
+
+    inline ~FileWatcher() noexcept {
+        stop();
+    }
+
+    // false when inotify could not be initialized, every watch() will fail.
+    _NODISCARD bool is_valid() const noexcept {
+        return _Inotify >= 0;
+    }
+
+    /// <summary>
+    /// Watch a file or a directory. For a directory, the callback receives changes
+    /// to any entry directly inside of it.
+    /// </summary>
+    inline Result<WatchId, FileWatcherError> watch(std::string_view path, Callback callback) noexcept {
+        if (!is_valid() || !_Running.load(std::memory_order_acquire))
+            return FileWatcherError::InitFailed;
+
+        auto _Path = std::string(path);
+        while (_Path.size() > 1 && _Path.back() == '/')
+            _Path.pop_back();
+
+        std::string _Dir, _Name;
+        struct stat _St = {};
+        if (::stat(_Path.c_str(), &_St) == 0 && S_ISDIR(_St.st_mode)) {
+            _Dir = _Path;
+        }
+        else {
+            auto _Slash = _Path.rfind('/');
+            if (_Slash == std::string::npos) {
+                _Dir = ".";
+                _Name = _Path;
+            }
+            else {
+                _Dir = _Slash == 0 ? "/" : _Path.substr(0, _Slash);
+                _Name = _Path.substr(_Slash + 1);
+            }
+        }
+
+        std::lock_guard _Lock(_Watch_mtx);
+        // inotify hands back the existing descriptor when the directory is already watched.
+        const int _Wd = inotify_add_watch(_Inotify, _Dir.c_str(), _Inotify_mask);
+        if (_Wd < 0)
+            return FileWatcherError::WatchFailed;
+
+        auto& _Entry = _Dirs[_Wd];
+        _Entry.path = _Dir;
+        const WatchId _Id = _Next_id++;
+        _Entry.subs.push_back(_Subscription{ _Id, std::move(_Name), std::move(callback) });
+        return WatchId{ _Id };
+    }
+
+    inline Result<placeholder, FileWatcherError> unwatch(WatchId id) noexcept {
+        std::lock_guard _Lock(_Watch_mtx);
+        for (auto it = _Dirs.begin(); it != _Dirs.end(); ++it) {
+            auto& _Subs = it->second.subs;
+            for (auto sub = _Subs.begin(); sub != _Subs.end(); ++sub) {
+                if (sub->id != id)
+                    continue;
+                _Subs.erase(sub);
+                if (_Subs.empty()) {
+                    inotify_rm_watch(_Inotify, it->first);
+                    _Dirs.erase(it);
+                }
+                return placeholder{};
+            }
+        }
+        return FileWatcherError::NotWatched;
+    }
+
+    /// <summary>
+    /// Stops both threads. Callbacks already handed to the worker still run, unless stop()
+    /// is called from a callback: then the worker finishes that callback and exits without
+    /// running the rest, so a callback may stop or destroy its own watcher.
+    /// </summary>
+    inline void stop() noexcept {
+        // the constructor cleans up after itself when it fails, and only the first
+        // stop() may touch the descriptors: the second can run on another thread.
+        if (!_Running.exchange(false, std::memory_order_acq_rel))
+            return;
+
+        const char _Byte = 1;
+        DISCARD(::write(_Wake[1], &_Byte, 1));
+        if (_Event_thread.joinable())
+            _Event_thread.join();
+
+        {
+            std::lock_guard _Lock(_Work->mtx);
+            _Work->stopping = true;
+        }
+        _Work->cv.notify_all();
+        if (std::this_thread::get_id() == _Worker_thread.get_id()) {
+            // joining would wait on ourselves.
+            _Work->abandoned.store(true, std::memory_order_release);
+            _Worker_thread.detach();
+        }
+        else if (_Worker_thread.joinable()) {
+            _Worker_thread.join();
+        }
+
+        _Close_descriptors();
+    }
+
+private:
+    inline void _Close_descriptors() noexcept {
+        if (_Inotify >= 0) {
+            ::close(_Inotify);
+            _Inotify = -1;
+        }
+        for (auto& fd : _Wake) {
+            if (fd >= 0) {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+    }
+
+    _NODISCARD static uint32 _Translate_mask(uint32_t mask) noexcept {
+        uint32 _Kinds = 0;
+        if (mask & (IN_CLOSE_WRITE | IN_MODIFY))
+            _Kinds |= FileChange_Modified;
+        if (mask & (IN_CREATE | IN_MOVED_TO))
+            _Kinds |= FileChange_Created;
+        if (mask & (IN_DELETE | IN_MOVED_FROM | IN_DELETE_SELF | IN_MOVE_SELF))
+            _Kinds |= FileChange_Removed;
+        if (mask & IN_ATTRIB)
+            _Kinds |= FileChange_Attributes;
+        return _Kinds;
+    }
+
+    inline void _Record(int wd, std::string_view name, std::string_view dir, uint32 kinds, Clock::time_point now) {
+        auto _Full = std::string(dir);
+        if (!name.empty()) {
+            if (_Full.back() != '/')
+                _Full.push_back('/');
+            _Full.append(name);
+        }
+
+        auto [it, inserted] = _Pending_changes.try_emplace(std::move(_Full));
+        if (inserted) {
+            it->second = _Pending{ wd, std::string(name), kinds, now, now };
+            return;
+        }
+        it->second.kinds |= kinds;
+        it->second.last_seen = now;
+    }
+
+    inline void _Drain_inotify(Clock::time_point now) {
+        alignas(inotify_event) char _Buffer[16 * (sizeof(inotify_event) + NAME_MAX + 1)];
+
+        for (;;) {
+            const auto _Read = ::read(_Inotify, _Buffer, sizeof(_Buffer));
+            if (_Read <= 0)
+                return;
+
+            std::lock_guard _Lock(_Watch_mtx);
+            for (char* ptr = _Buffer; ptr < _Buffer + _Read;) {
+                const auto* _Event = reinterpret_cast<const inotify_event*>(ptr);
+                ptr += sizeof(inotify_event) + _Event->len;
+
+                if (_Event->mask & IN_Q_OVERFLOW) {
+                    // We cannot know what was lost, so everyone gets told.
+                    for (const auto& [wd, dir] : _Dirs) {
+                        for (const auto& sub : dir.subs)
+                            _Record(wd, sub.name, dir.path, FileChange_Overflow, now);
+                    }
+                    continue;
+                }
+
+                auto _Dir = _Dirs.find(_Event->wd);
+                if (_Dir == _Dirs.end())
+                    continue;
+                if (_Event->mask & IN_IGNORED) {
+                    // The directory itself is gone, the kernel already dropped the watch.
+                    for (const auto& sub : _Dir->second.subs)
+                        _Record(_Event->wd, sub.name, _Dir->second.path, FileChange_Removed, now);
+                    continue;
+                }
+
+                const auto _Name = _Event->len ? std::string_view(_Event->name) : std::string_view{};
+                _Record(_Event->wd, _Name, _Dir->second.path, _Translate_mask(_Event->mask), now);
+            }
+        }
+    }
+
+    // Hands quiet paths to the worker, returns how long until the next pending path settles.
+    inline int _Flush_settled(Clock::time_point now) {
+        using namespace std::chrono;
+        // A path that never goes quiet is still reported every few windows.
+        const auto _Max_latency = _Coalesce * 4;
+        auto _Next = milliseconds::max();
+        std::vector<_Job> _Ready;
+
+        {
+            std::lock_guard _Lock(_Watch_mtx);
+            for (auto it = _Pending_changes.begin(); it != _Pending_changes.end();) {
+                const auto& _Change = it->second;
+                const auto _Quiet_at = _Change.last_seen + _Coalesce;
+                const auto _Forced_at = _Change.first_seen + _Max_latency;
+                const auto _Due = _Quiet_at < _Forced_at ? _Quiet_at : _Forced_at;
+
+                if (_Due > now) {
+                    const auto _Wait = duration_cast<milliseconds>(_Due - now) + milliseconds(1);
+                    if (_Wait < _Next)
+                        _Next = _Wait;
+                    ++it;
+                    continue;
+                }
+
+                if (auto _Dir = _Dirs.find(_Change.wd); _Dir != _Dirs.end()) {
+                    for (const auto& sub : _Dir->second.subs) {
+                        if (sub.name.empty() || sub.name == _Change.name)
+                            _Ready.push_back(_Job{ sub.callback, FileChange{ it->first, _Change.kinds } });
+                    }
+                }
+                if (_Change.kinds & (FileChange_Removed | FileChange_Overflow)) {
+                    // The kernel drops the watch when the directory goes away, forget it too.
+                    if (auto _Dir = _Dirs.find(_Change.wd); _Dir != _Dirs.end()
+                        && ::access(_Dir->second.path.c_str(), F_OK) != 0) {
+                        _Dirs.erase(_Dir);
+                    }
+                }
+                it = _Pending_changes.erase(it);
+            }
+        }
+
+        if (!_Ready.empty()) {
+            {
+                std::lock_guard _Lock(_Work->mtx);
+                for (auto& job : _Ready)
+                    _Work->jobs.push_back(std::move(job));
+            }
+            _Work->cv.notify_one();
+        }
+
+        return _Next == milliseconds::max() ? -1 : static_cast<int>(_Next.count());
+    }
+
+    inline void _Event_loop() {
+        int _Timeout = -1;
+        while (_Running.load(std::memory_order_acquire)) {
+            pollfd _Fds[2] = {
+                { _Inotify, POLLIN, 0 },
+                { _Wake[0], POLLIN, 0 },
+            };
+            const int _Ready = ::poll(_Fds, 2, _Timeout);
+            if (_Ready < 0 && errno != EINTR)
+                break;
+            if (_Fds[1].revents & POLLIN)
+                break;
+
+            const auto _Now = Clock::now();
+            if (_Fds[0].revents & POLLIN)
+                _Drain_inotify(_Now);
+            _Timeout = _Flush_settled(_Now);
+        }
+    }
+
+    static inline void _Worker_loop(std::shared_ptr<_Worker_state> work) {
+        std::vector<_Job> _Batch;
+        for (;;) {
+            {
+                std::unique_lock _Lock(work->mtx);
+                work->cv.wait(_Lock, [&]() {
+                    return !work->jobs.empty() || work->stopping;
+                });
+                if (work->jobs.empty())
+                    return;
+                _Batch.swap(work->jobs);
+            }
+
+            for (auto& job : _Batch) {
+                if (work->abandoned.load(std::memory_order_acquire))
+                    return;
+                job.callback(job.change);
+            }
+            _Batch.clear();
+        }
+    }
+};
+
+#endif
+
+_STD_API_END
@@ -15,22 +15,13 @@ template<class L, class R>
 struct pair {
     L key;
     R value;
-};
-
-template<class Container, typename T = typename Container::value_type>
-_NODISCARD 
-_STD_API 
-_Algo_vector<pair<size_t, T&>> 
-enumerate(Container& container) noexcept {
-    _Algo_vector<pair<size_t, T&>> result = {};
 
-    for (size_t index = 0; index < container.size(); ++index) {
-        T& el = container.at(index);
-        result.emplace_back(index, el);
+    // std algorithms find this before the stud::swap/std::swap pair, which are ambiguous here.
+    friend _STD_API void swap(pair& left, pair& right) noexcept {
+        std::swap(left.key, right.key);
+        std::swap(left.value, right.value);
     }
-
-    return result;
-}
+};
 
 _STD_API 
 size_t 
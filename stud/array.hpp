@@ -3,6 +3,7 @@
 
 #include <initializer_list>
 #include <format>
+#include <iterator>
 #include <string>
 
 #include "forward.hpp"
@@ -11,6 +12,9 @@
 #include "concept.hpp"
 #include "type_traits.hpp"
 #include "iterator.hpp"
+#include "clone.hpp"
+#include "simd.hpp"
+#include "format.hpp"
 
 _STD_API_BEGIN
 
@@ -78,8 +82,9 @@ private:
 public:
     static constexpr size_t SIZE = N;
 
-    using iterator = iterator<Array<T, N>>;
     using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
 
     _STD_API Array() = default;
     _STD_API Array(std::initializer_list<T> elements) noexcept {
@@ -87,10 +92,7 @@ public:
         copy_to<N>(_elems, elements);
     }
     _STD_API Array(const T& initializer) noexcept {
-        auto _Inner = data();
-        for (size_t offset = 0; offset < N; ++offset) {
-            _Inner[offset] = initializer;
-        }
+        fill(initializer);
     }
     _STD_API Array(const T(&init)[N]) noexcept {
         for (size_t off = 0; off < N; ++off) {
@@ -118,6 +120,12 @@ public:
     }
 
     _STD_API void fill(const T& element) noexcept {
+        if constexpr (_DETAIL _Simd_element<T>) {
+            if (!std::is_constant_evaluated()) {
+                _DETAIL _Simd_fill(_elems, N, element);
+                return;
+            }
+        }
         for (size_t index = 0; index < N; ++index) {
             _elems[index] = element;
         }
@@ -151,43 +159,78 @@ public:
     }
 
     _NODISCARD _STD_API iterator begin() noexcept {
-        return iterator(data());
+        return data();
     }
     _NODISCARD _STD_API iterator end() noexcept {
-        return iterator(data() + N);
+        return data() + N;
+    }
+    _NODISCARD _STD_API const_iterator begin() const noexcept {
+        return data();
+    }
+    _NODISCARD _STD_API const_iterator end() const noexcept {
+        return data() + N;
     }
 
     /// <summary>
-    /// Linear search for an item that matches the parameter.
+    /// Linear search for an item that matches the parameter. Integers, enums, float and
+    /// double are compared a vector register at a time.
     /// </summary>
-    /// <param name="item"></param>
-    /// <returns></returns>
     _NODISCARD _STD_API bool contains(const T& item) const {
-        for (std::size_t i = 0; i < this->size(); ++i) {
-            const T& _This_item = this->at(i);
-            if (_This_item == item)
-                return true;
+        return find(item) != end();
+    }
+
+    // The first element equal to `item`, or end().
+    _NODISCARD _STD_API iterator find(const T& item) noexcept {
+        return _elems + _Find(item);
+    }
+    _NODISCARD _STD_API const_iterator find(const T& item) const noexcept {
+        return _elems + _Find(item);
+    }
+
+    _NODISCARD _STD_API size_t count(const T& item) const noexcept {
+        if constexpr (_DETAIL _Simd_element<T>) {
+            if (!std::is_constant_evaluated())
+                return _DETAIL _Simd_count(_elems, N, item);
+        }
+        size_t _Matches = 0;
+        for (size_t index = 0; index < N; ++index) {
+            if (_elems[index] == item)
+                ++_Matches;
         }
-        return false;
+        return _Matches;
     }
 
-    _STD_API std::string to_string()
-    {
-        auto result = std::string{"["};
-        for (const auto& element : *this) {
-            if constexpr (ToString<T>) {
-                result.append(std::format("{}, ", element.to_string()));
-            }
-            if constexpr (is_pointer_v<T>) {
-                result.append(std::format("{}, ", (const void*)element));
-            }
-            else {
-                result.append(std::format("{}, ", element));
-            }
+    _NODISCARD friend _STD_API bool operator==(const Array& left, const Array& right) noexcept {
+        if constexpr (_DETAIL _Simd_element<T>) {
+            if (!std::is_constant_evaluated())
+                return _DETAIL _Simd_equal(left._elems, right._elems, N);
         }
+        for (size_t index = 0; index < N; ++index) {
+            if (!(left._elems[index] == right._elems[index]))
+                return false;
+        }
+        return true;
+    }
 
-        result.append("]");
-        return result;
+    // "[a, b, c]", see the std::formatter below.
+    _NODISCARD inline std::string to_string() const requires _DETAIL _Formattable_element<T> {
+        std::string _Result;
+        // brackets, separators and a few characters for each element.
+        _Result.reserve(2 + N * 4);
+        std::format_to(std::back_inserter(_Result), "{}", *this);
+        return _Result;
+    }
+private:
+    _NODISCARD _STD_API size_t _Find(const T& item) const noexcept {
+        if constexpr (_DETAIL _Simd_element<T>) {
+            if (!std::is_constant_evaluated())
+                return _DETAIL _Simd_find(_elems, N, item);
+        }
+        for (size_t index = 0; index < N; ++index) {
+            if (_elems[index] == item)
+                return index;
+        }
+        return N;
     }
 };
 
@@ -201,5 +244,18 @@ _STD_API auto make_array(Ts&&... args) noexcept {
 
 _STD_API_END
 
+namespace std {
+
+template <class T, size_t N>
+    requires stud::__detail::_Formattable_element<T>
+struct formatter<stud::Array<T, N>, char> : stud::__detail::_Sequence_formatter<T> {
+    template <class FormatContext>
+    auto format(const stud::Array<T, N>& array, FormatContext& ctx) const {
+        return this->_Format(array.begin(), array.end(), ctx);
+    }
+};
+
+} // namespace std
+
 #define _STD_ARRAY
 #endif
\ No newline at end of file
@@ -1,44 +1,729 @@
 #pragma once
 
-#include "forward.hpp"
-#include "string.hpp"
-#include "array.hpp"
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <vector>
 
-_STD_API_BEGIN
+#if defined(__AVX2__) || defined(__BMI2__)
+#include <immintrin.h>
+#endif
 
-template <size_t N>
-class BitSet;
+#include "forward.hpp"
+#include "panic.hpp"
+#include "stddef.hpp"
+#include "result.hpp"
+
+_STD_DETAIL_API
 
-template <size_t _NumBytes>
-struct _ByteStorage {
-	static constexpr size_t _Count = _NumBytes;
-	std::uint8_t storage[_NumBytes];
+enum class _Bit_op {
+	And, Or, Xor, AndNot
 };
 
-template <class T, size_t _Coff = T::StorageType::_Count>
-static _STD_API size_t _Get_storage_index_from_bit_position(const std::size_t _Bitoff) noexcept {
-	if (_Bitoff > _Coff) {
-		return _Coff / std::hardware_destructive_interference_size;
+// dst = dst <op> src over `count` words, 256 bits at a time when AVX2 is available.
+template <_Bit_op Op>
+inline void _Bitwise_words(uint64* dst, const uint64* src, size_t count) noexcept {
+	size_t _Index = 0;
+#if defined(__AVX2__)
+	for (; _Index + 4 <= count; _Index += 4) {
+		const __m256i _Left = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + _Index));
+		const __m256i _Right = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + _Index));
+		__m256i _Out;
+		if constexpr (Op == _Bit_op::And)
+			_Out = _mm256_and_si256(_Left, _Right);
+		else if constexpr (Op == _Bit_op::Or)
+			_Out = _mm256_or_si256(_Left, _Right);
+		else if constexpr (Op == _Bit_op::Xor)
+			_Out = _mm256_xor_si256(_Left, _Right);
+		else
+			_Out = _mm256_andnot_si256(_Right, _Left);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + _Index), _Out);
+	}
+#endif
+	for (; _Index < count; ++_Index) {
+		if constexpr (Op == _Bit_op::And)
+			dst[_Index] &= src[_Index];
+		else if constexpr (Op == _Bit_op::Or)
+			dst[_Index] |= src[_Index];
+		else if constexpr (Op == _Bit_op::Xor)
+			dst[_Index] ^= src[_Index];
+		else
+			dst[_Index] &= ~src[_Index];
 	}
+}
+
+inline void _Invert_words(uint64* dst, size_t count) noexcept {
+	size_t _Index = 0;
+#if defined(__AVX2__)
+	const __m256i _Ones = _mm256_set1_epi64x(-1);
+	for (; _Index + 4 <= count; _Index += 4) {
+		const __m256i _Value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + _Index));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + _Index), _mm256_xor_si256(_Value, _Ones));
+	}
+#endif
+	for (; _Index < count; ++_Index)
+		dst[_Index] = ~dst[_Index];
+}
+
+inline size_t _Popcount_words(const uint64* words, size_t count) noexcept {
+	size_t _Total = 0;
+	for (size_t index = 0; index < count; ++index)
+		_Total += static_cast<size_t>(std::popcount(words[index]));
+	return _Total;
+}
 
-	return _Get_storage_index_from_bit_position<T, _Coff - 8>(_Bitoff);
+// First set bit at or after `from`, or `bits` when there is none.
+inline size_t _Find_next_set(const uint64* words, size_t bits, size_t from) noexcept {
+	if (from >= bits)
+		return bits;
+	size_t _Word = from / 64;
+	uint64 _Current = words[_Word] & (~uint64{ 0 } << (from % 64));
+	const size_t _Count = (bits + 63) / 64;
+	for (;;) {
+		if (_Current) {
+			const size_t _Found = _Word * 64 + static_cast<size_t>(std::countr_zero(_Current));
+			return _Found < bits ? _Found : bits;
+		}
+		if (++_Word >= _Count)
+			return bits;
+		_Current = words[_Word];
+	}
 }
 
+// Iterates the positions of the set bits, one countr_zero (tzcnt) per bit.
+class _Set_bit_iterator {
+private:
+	const uint64* _Words;
+	size_t _Bits;
+	size_t _Pos;
+public:
+	using value_type = size_t;
+	using difference_type = ptrdiff;
+
+	_STD_API _Set_bit_iterator(const uint64* words, size_t bits, size_t pos) noexcept
+		: _Words(words), _Bits(bits), _Pos(pos)
+	{}
+
+	_STD_API size_t operator*() const noexcept {
+		return _Pos;
+	}
+	inline _Set_bit_iterator& operator++() noexcept {
+		_Pos = _Find_next_set(_Words, _Bits, _Pos + 1);
+		return *this;
+	}
+	inline _Set_bit_iterator operator++(int) noexcept {
+		auto _Copy = *this;
+		++(*this);
+		return _Copy;
+	}
+	_STD_API bool operator==(const _Set_bit_iterator& other) const noexcept {
+		return _Pos == other._Pos;
+	}
+	_STD_API bool operator!=(const _Set_bit_iterator& other) const noexcept {
+		return _Pos != other._Pos;
+	}
+};
+
+_STD_API_END
+
+_STD_API_BEGIN
+
+/// <summary>
+/// A fixed amount of bits packed into 64 bit words. Bits past N in the last word are
+/// always kept clear, so count() and comparisons can work on whole words.
+/// Iterating a BitSet visits the positions of the set bits in increasing order.
+/// </summary>
 template <size_t N>
 class BitSet {
 public:
-	static_assert(N % 8 == 0, "The amount of bits must be a multiple of 8.");
+	static constexpr size_t WordBits = 64;
+	static constexpr size_t WordCount = N == 0 ? 1 : (N + WordBits - 1) / WordBits;
+
+	using word_type = uint64;
+	using iterator = _DETAIL _Set_bit_iterator;
+private:
+	static constexpr uint64 _Tail_mask = (N % WordBits) == 0 ? ~uint64{ 0 } : (uint64{ 1 } << (N % WordBits)) - 1;
+
+	alignas(32) uint64 _Words[WordCount]{};
+
+	_STD_API void _Clear_tail() noexcept {
+		if constexpr (N == 0)
+			_Words[0] = 0;
+		else
+			_Words[WordCount - 1] &= _Tail_mask;
+	}
+public:
+	_STD_API BitSet() noexcept = default;
 
-	static _STD_API bool _IsX64 = std::hardware_destructive_interference_size == 64 ? true : false;
-	static _STD_API size_t _NumberOfBytesNeeded = N / (_IsX64 ? 8 : 4);
+	_STD_API BitSet& set(size_t pos, bool value = true) noexcept {
+#if defined (_DEBUG)
+		panic(IF(pos >= N), "bit position out of range: ({} >= {})", pos, N);
+#endif
+		const uint64 _Mask = uint64{ 1 } << (pos % WordBits);
+		_Words[pos / WordBits] = value ? (_Words[pos / WordBits] | _Mask) : (_Words[pos / WordBits] & ~_Mask);
+		return *this;
+	}
+	_STD_API BitSet& set() noexcept {
+		for (auto& word : _Words)
+			word = ~uint64{ 0 };
+		_Clear_tail();
+		return *this;
+	}
+
+	_STD_API BitSet& reset(size_t pos) noexcept {
+		return set(pos, false);
+	}
+	_STD_API BitSet& reset() noexcept {
+		for (auto& word : _Words)
+			word = 0;
+		return *this;
+	}
+
+	_STD_API BitSet& flip(size_t pos) noexcept {
+#if defined (_DEBUG)
+		panic(IF(pos >= N), "bit position out of range: ({} >= {})", pos, N);
+#endif
+		_Words[pos / WordBits] ^= uint64{ 1 } << (pos % WordBits);
+		return *this;
+	}
+	inline BitSet& flip() noexcept {
+		_DETAIL _Invert_words(_Words, WordCount);
+		_Clear_tail();
+		return *this;
+	}
+
+	_NODISCARD _STD_API bool test(size_t pos) const noexcept {
+#if defined (_DEBUG)
+		panic(IF(pos >= N), "bit position out of range: ({} >= {})", pos, N);
+#endif
+		return (_Words[pos / WordBits] >> (pos % WordBits)) & 1;
+	}
+	_NODISCARD _STD_API bool operator[](size_t pos) const noexcept {
+		return test(pos);
+	}
+
+	// Number of set bits, one popcnt per word.
+	_NODISCARD inline size_t count() const noexcept {
+		return _DETAIL _Popcount_words(_Words, WordCount);
+	}
+
+	_NODISCARD _STD_API bool any() const noexcept {
+		for (const auto word : _Words) {
+			if (word)
+				return true;
+		}
+		return false;
+	}
+	_NODISCARD _STD_API bool none() const noexcept {
+		return !any();
+	}
+	_NODISCARD inline bool all() const noexcept {
+		return count() == N;
+	}
+
+	// Position of the first set bit, or size() when none are set.
+	_NODISCARD inline size_t find_first() const noexcept {
+		return _DETAIL _Find_next_set(_Words, N, 0);
+	}
+	// Position of the first set bit after pos, or size() when there is none.
+	_NODISCARD inline size_t find_next(size_t pos) const noexcept {
+		return _DETAIL _Find_next_set(_Words, N, pos + 1);
+	}
+
+	inline BitSet& operator&=(const BitSet& other) noexcept {
+		_DETAIL _Bitwise_words<_DETAIL _Bit_op::And>(_Words, other._Words, WordCount);
+		return *this;
+	}
+	inline BitSet& operator|=(const BitSet& other) noexcept {
+		_DETAIL _Bitwise_words<_DETAIL _Bit_op::Or>(_Words, other._Words, WordCount);
+		return *this;
+	}
+	inline BitSet& operator^=(const BitSet& other) noexcept {
+		_DETAIL _Bitwise_words<_DETAIL _Bit_op::Xor>(_Words, other._Words, WordCount);
+		return *this;
+	}
+	// Clear every bit that is set in other (this & ~other), without building ~other.
+	inline BitSet& subtract(const BitSet& other) noexcept {
+		_DETAIL _Bitwise_words<_DETAIL _Bit_op::AndNot>(_Words, other._Words, WordCount);
+		return *this;
+	}
+
+	_NODISCARD inline BitSet operator&(const BitSet& other) const noexcept {
+		auto _Copy = *this;
+		return _Copy &= other;
+	}
+	_NODISCARD inline BitSet operator|(const BitSet& other) const noexcept {
+		auto _Copy = *this;
+		return _Copy |= other;
+	}
+	_NODISCARD inline BitSet operator^(const BitSet& other) const noexcept {
+		auto _Copy = *this;
+		return _Copy ^= other;
+	}
+	_NODISCARD inline BitSet operator~() const noexcept {
+		auto _Copy = *this;
+		return _Copy.flip();
+	}
+
+	_NODISCARD _STD_API bool operator==(const BitSet& other) const noexcept {
+		for (size_t index = 0; index < WordCount; ++index) {
+			if (_Words[index] != other._Words[index])
+				return false;
+		}
+		return true;
+	}
+	_NODISCARD _STD_API bool operator!=(const BitSet& other) const noexcept {
+		return !(*this == other);
+	}
+
+	_NODISCARD inline iterator begin() const noexcept {
+		return iterator(_Words, N, find_first());
+	}
+	_NODISCARD _STD_API iterator end() const noexcept {
+		return iterator(_Words, N, N);
+	}
+
+	_NODISCARD _STD_API size_t size() const noexcept {
+		return N;
+	}
+
+	_NODISCARD _STD_API uint64* words() noexcept {
+		return _Words;
+	}
+	_NODISCARD _STD_API const uint64* words() const noexcept {
+		return _Words;
+	}
+
+	// Raw byte view of the words (little endian bit order on x86).
+	_NODISCARD inline std::uint8_t* storage() noexcept {
+		return reinterpret_cast<std::uint8_t*>(_Words);
+	}
+	_NODISCARD inline const std::uint8_t* storage() const noexcept {
+		return reinterpret_cast<const std::uint8_t*>(_Words);
+	}
+};
+
+_STD_API_END
+
+_STD_DETAIL_API
+
+// Position of the k-th (0 based) set bit of a word, k must be below popcount(word).
+inline size_t _Select_in_word(uint64 word, size_t k) noexcept {
+#if defined(__BMI2__)
+	return static_cast<size_t>(std::countr_zero(_pdep_u64(uint64{ 1 } << k, word)));
+#else
+	for (; k; --k)
+		word &= word - 1;
+	return static_cast<size_t>(std::countr_zero(word));
+#endif
+}
+
+_STD_API_END
+
+_STD_API_BEGIN
 
-	using StorageType = _ByteStorage<_NumberOfBytesNeeded>;
+enum class BitVectorError {
+	InvalidHeader,
+	Truncated,
+};
+
+/// <summary>
+/// A read only bit vector with its rank/select index, pointing at memory it does not own.
+/// This is what DynamicBitVector::serialize() writes, so a file can be mmap'ed and queried in place.
+///
+/// Index layout:
+///   superblocks, every 65536 bits, absolute amount of ones before it (uint64)
+///   blocks, every 512 bits, ones since the start of its superblock (uint16)
+///   select samples, the block holding every 4096th one (uint64)
+/// rank() is two lookups and at most 8 popcounts, select() is a sample lookup, a binary search
+/// over the blocks between two samples and a scan of at most 8 words.
+/// </summary>
+class BitVectorView {
+public:
+	static constexpr size_t BlockBits = 512;
+	static constexpr size_t SuperBlockBits = 65536;
+	static constexpr size_t SelectSampleRate = 4096;
+	static constexpr uint64 Magic = 0x3156424455545300ull; // "\0STUDBV1"
+private:
+	static constexpr size_t _Words_per_block = BlockBits / 64;
+	static constexpr size_t _Blocks_per_super = SuperBlockBits / BlockBits;
+
+	struct _Header {
+		uint64 magic;
+		uint64 bits;
+		uint64 ones;
+		uint64 words;
+		uint64 supers;
+		uint64 blocks;
+		uint64 samples;
+	};
+
+	const uint64* _Words{ nullptr };
+	const uint64* _Supers{ nullptr };
+	const uint16_t* _Blocks{ nullptr };
+	const uint64* _Samples{ nullptr };
+	size_t _Bits{ 0 };
+	size_t _Ones{ 0 };
+	size_t _Block_count{ 0 };
+	size_t _Sample_count{ 0 };
+
+	_NODISCARD _STD_API size_t _Ones_before_block(size_t block) const noexcept {
+		return static_cast<size_t>(_Supers[block / _Blocks_per_super]) + _Blocks[block];
+	}
+
+	friend class DynamicBitVector;
+public:
+	_STD_API BitVectorView() noexcept = default;
+
+	_STD_API BitVectorView(const uint64* words, size_t bits, size_t ones,
+		const uint64* supers, const uint16_t* blocks, size_t block_count,
+		const uint64* samples, size_t sample_count) noexcept
+		: _Words(words), _Supers(supers), _Blocks(blocks), _Samples(samples)
+		, _Bits(bits), _Ones(ones), _Block_count(block_count), _Sample_count(sample_count)
+	{}
+
+	/// <summary>
+	/// Interpret serialized bytes (see DynamicBitVector::serialize) without copying them.
+	/// `data` must be 8 byte aligned (mmap always is) and outlive the view.
+	/// </summary>
+	inline static Result<BitVectorView, BitVectorError> from_bytes(const void* data, size_t length) noexcept {
+		if (length < sizeof(_Header) || reinterpret_cast<uintptr>(data) % alignof(uint64) != 0)
+			return BitVectorError::Truncated;
+
+		_Header _Head;
+		std::memcpy(&_Head, data, sizeof(_Head));
+		// the counts are rebuilt from bits and ones without rounding up, which could wrap.
+		if (_Head.magic != Magic || _Head.ones > _Head.bits
+			|| _Head.words != _Ceil_div(_Head.bits, 64)
+			|| _Head.blocks != _Ceil_div(_Head.bits, BlockBits) + 1
+			|| _Head.supers != _Ceil_div(_Head.blocks, _Blocks_per_super)
+			|| _Head.samples != _Ceil_div(_Head.ones, SelectSampleRate))
+			return BitVectorError::InvalidHeader;
+		size_t _Size = 0;
+		if (!_Checked_serialized_size(_Head.words, _Head.supers, _Head.blocks, _Head.samples, _Size))
+			return BitVectorError::InvalidHeader;
+		if (length < _Size)
+			return BitVectorError::Truncated;
+
+		const auto* _Base = static_cast<const uint8_t*>(data) + sizeof(_Header);
+		const auto* _Words = reinterpret_cast<const uint64*>(_Base);
+		const auto* _Supers = _Words + _Head.words;
+		const auto* _Blocks = reinterpret_cast<const uint16_t*>(_Supers + _Head.supers);
+		const auto* _Samples = reinterpret_cast<const uint64*>(_Base + (_Head.words + _Head.supers) * 8 + _Padded_block_bytes(_Head.blocks));
+		// select() starts its search at a sample, it has to name a block.
+		for (size_t sample = 0; sample < _Head.samples; ++sample) {
+			if (_Samples[sample] >= _Head.blocks)
+				return BitVectorError::InvalidHeader;
+		}
+		return BitVectorView(_Words, _Head.bits, _Head.ones, _Supers, _Blocks, _Head.blocks, _Samples, _Head.samples);
+	}
+
+	_NODISCARD _STD_API static size_t serialized_size(size_t words, size_t supers, size_t blocks, size_t samples) noexcept {
+		size_t _Size = 0;
+		panic(IF(!_Checked_serialized_size(words, supers, blocks, samples, _Size)), "BitVectorView: serialized size does not fit in a size_t.");
+		return _Size;
+	}
+	// false when the size does not fit in a size_t.
+	_NODISCARD _STD_API static bool _Checked_serialized_size(uint64 words, uint64 supers, uint64 blocks, uint64 samples, size_t& size) noexcept {
+		constexpr uint64 _Max_entries = SIZE_MAX / 8;
+		if (words > _Max_entries || supers > _Max_entries || blocks > _Max_entries || samples > _Max_entries)
+			return false;
+		const size_t _Parts[] = { words * 8, supers * 8, _Padded_block_bytes(blocks), samples * 8 };
+		size = sizeof(_Header);
+		for (const size_t part : _Parts) {
+			if (part > SIZE_MAX - size)
+				return false;
+			size += part;
+		}
+		return true;
+	}
+	_NODISCARD _STD_API static uint64 _Ceil_div(uint64 value, uint64 divisor) noexcept {
+		return value / divisor + (value % divisor != 0);
+	}
+	_NODISCARD _STD_API static size_t _Padded_block_bytes(size_t blocks) noexcept {
+		return (blocks * sizeof(uint16_t) + 7) & ~size_t{ 7 };
+	}
+
+	_NODISCARD _STD_API size_t size() const noexcept {
+		return _Bits;
+	}
+	// Total amount of set bits.
+	_NODISCARD _STD_API size_t count() const noexcept {
+		return _Ones;
+	}
+
+	_NODISCARD _STD_API bool test(size_t pos) const noexcept {
+		return (_Words[pos / 64] >> (pos % 64)) & 1;
+	}
+
+	// Amount of set bits in [0, pos).
+	_NODISCARD inline size_t rank(size_t pos) const noexcept {
+		if (pos >= _Bits)
+			return _Ones;
+		const size_t _Block = pos / BlockBits;
+		size_t _Rank = _Ones_before_block(_Block);
+		const size_t _Word = pos / 64;
+		for (size_t index = _Block * _Words_per_block; index < _Word; ++index)
+			_Rank += static_cast<size_t>(std::popcount(_Words[index]));
+		const size_t _Offset = pos % 64;
+		if (_Offset)
+			_Rank += static_cast<size_t>(std::popcount(_Words[_Word] << (64 - _Offset)));
+		return _Rank;
+	}
+
+	// Amount of clear bits in [0, pos).
+	_NODISCARD inline size_t rank0(size_t pos) const noexcept {
+		return (pos < _Bits ? pos : _Bits) - rank(pos);
+	}
+
+	// Position of the k-th (0 based) set bit, or size() when there are not that many.
+	_NODISCARD inline size_t select(size_t k) const noexcept {
+		if (k >= _Ones)
+			return _Bits;
+
+		const size_t _Sample = k / SelectSampleRate;
+		size_t _Low = static_cast<size_t>(_Samples[_Sample]);
+		size_t _High = _Sample + 1 < _Sample_count ? static_cast<size_t>(_Samples[_Sample + 1]) : _Block_count - 1;
+		// last block whose leading count is <= k.
+		while (_Low < _High) {
+			const size_t _Mid = _Low + (_High - _Low + 1) / 2;
+			if (_Ones_before_block(_Mid) <= k)
+				_Low = _Mid;
+			else
+				_High = _Mid - 1;
+		}
+
+		size_t _Remaining = k - _Ones_before_block(_Low);
+		// bounded by the words, a view over a corrupt image must not read past them.
+		const size_t _Word_count = _Bits / 64 + (_Bits % 64 != 0);
+		for (size_t index = _Low * _Words_per_block; index < _Word_count; ++index) {
+			const auto _Word = _Words[index];
+			const auto _Ones_here = static_cast<size_t>(std::popcount(_Word));
+			if (_Remaining < _Ones_here)
+				return index * 64 + _DETAIL _Select_in_word(_Word, _Remaining);
+			_Remaining -= _Ones_here;
+		}
+		return _Bits;
+	}
+};
+
+/// <summary>
+/// A runtime sized bit vector built for succinct indexes: append in bulk, call build_index(),
+/// then answer rank/select in (near) constant time. Modifying the bits invalidates the index.
+/// </summary>
+class DynamicBitVector {
 private:
-	StorageType _Storage;
+	std::vector<uint64> _Words;
+	size_t _Bits{ 0 };
+
+	std::vector<uint64> _Supers;
+	std::vector<uint16_t> _Blocks;
+	std::vector<uint64> _Samples;
+	size_t _Ones{ 0 };
+	bool _Indexed{ false };
 public:
-	_STD_API std::uint8_t* storage() noexcept {
-		return _Storage.storage;
+	DynamicBitVector() noexcept = default;
+	inline explicit DynamicBitVector(size_t bits, bool value = false) noexcept {
+		resize(bits, value);
+	}
+
+	inline void reserve(size_t bits) noexcept {
+		_Words.reserve((bits + 63) / 64);
+	}
+
+	inline void resize(size_t bits, bool value = false) noexcept {
+		const size_t _Old = _Bits;
+		_Words.resize((bits + 63) / 64, value ? ~uint64{ 0 } : 0);
+		if (value && bits > _Old && _Old % 64) {
+			// the partially used word gets its upper bits set too.
+			_Words[_Old / 64] |= ~uint64{ 0 } << (_Old % 64);
+		}
+		_Bits = bits;
+		_Clear_tail();
+		_Indexed = false;
+	}
+
+	inline void clear() noexcept {
+		_Words.clear();
+		_Bits = 0;
+		_Indexed = false;
+	}
+
+	inline void push_back(bool value) noexcept {
+		if (_Bits % 64 == 0)
+			_Words.push_back(0);
+		_Words.back() |= uint64{ value } << (_Bits % 64);
+		++_Bits;
+		_Indexed = false;
+	}
+
+	// Append the low `count` bits of `bits` (count <= 64), lowest bit first.
+	inline void append_bits(uint64 bits, size_t count) noexcept {
+		if (count == 0)
+			return;
+		if (count < 64)
+			bits &= (uint64{ 1 } << count) - 1;
+		const size_t _Offset = _Bits % 64;
+		if (_Offset == 0) {
+			_Words.push_back(bits);
+		}
+		else {
+			_Words.back() |= bits << _Offset;
+			if (_Offset + count > 64)
+				_Words.push_back(bits >> (64 - _Offset));
+		}
+		_Bits += count;
+		_Indexed = false;
+	}
+
+	// Append `count` bits taken from an array of words, lowest bit of words[0] first.
+	inline void append_words(const uint64* words, size_t count) noexcept {
+		if (_Bits % 64 == 0) {
+			const size_t _Full = count / 64;
+			_Words.insert(_Words.end(), words, words + _Full);
+			_Bits += _Full * 64;
+			if (count % 64)
+				append_bits(words[_Full], count % 64);
+			_Indexed = false;
+			return;
+		}
+		for (size_t index = 0; index * 64 < count; ++index) {
+			const size_t _Take = count - index * 64 < 64 ? count - index * 64 : 64;
+			append_bits(words[index], _Take);
+		}
+	}
+
+	inline void set(size_t pos, bool value = true) noexcept {
+#if defined (_DEBUG)
+		panic(IF(pos >= _Bits), "bit position out of range: ({} >= {})", pos, _Bits);
+#endif
+		const uint64 _Mask = uint64{ 1 } << (pos % 64);
+		_Words[pos / 64] = value ? (_Words[pos / 64] | _Mask) : (_Words[pos / 64] & ~_Mask);
+		_Indexed = false;
+	}
+	inline void reset(size_t pos) noexcept {
+		set(pos, false);
+	}
+
+	_NODISCARD inline bool test(size_t pos) const noexcept {
+#if defined (_DEBUG)
+		panic(IF(pos >= _Bits), "bit position out of range: ({} >= {})", pos, _Bits);
+#endif
+		return (_Words[pos / 64] >> (pos % 64)) & 1;
+	}
+	_NODISCARD inline bool operator[](size_t pos) const noexcept {
+		return test(pos);
+	}
+
+	_NODISCARD inline size_t size() const noexcept {
+		return _Bits;
+	}
+	_NODISCARD inline size_t count() const noexcept {
+		return _Indexed ? _Ones : _DETAIL _Popcount_words(_Words.data(), _Words.size());
+	}
+
+	inline DynamicBitVector& operator|=(const DynamicBitVector& other) noexcept {
+		panic(IF(other._Bits != _Bits), "DynamicBitVector: size mismatch ({} != {})", other._Bits, _Bits);
+		_DETAIL _Bitwise_words<_DETAIL _Bit_op::Or>(_Words.data(), other._Words.data(), _Words.size());
+		_Indexed = false;
+		return *this;
+	}
+
+	_NODISCARD inline const uint64* words() const noexcept {
+		return _Words.data();
+	}
+	_NODISCARD inline size_t word_count() const noexcept {
+		return _Words.size();
+	}
+
+	_NODISCARD inline bool is_indexed() const noexcept {
+		return _Indexed;
+	}
+
+	// (Re)build the rank/select index, one pass over the words.
+	inline void build_index() noexcept {
+		constexpr size_t _Words_per_block = BitVectorView::BlockBits / 64;
+		constexpr size_t _Blocks_per_super = BitVectorView::SuperBlockBits / BitVectorView::BlockBits;
+
+		// one extra block past the end, so select can always look at the "next" block.
+		const size_t _Block_count = (_Bits + BitVectorView::BlockBits - 1) / BitVectorView::BlockBits + 1;
+		_Blocks.assign(_Block_count, 0);
+		_Supers.assign((_Block_count + _Blocks_per_super - 1) / _Blocks_per_super, 0);
+		_Samples.clear();
+
+		size_t _Total = 0;
+		size_t _Super_start = 0;
+		for (size_t block = 0; block < _Block_count; ++block) {
+			if (block % _Blocks_per_super == 0) {
+				_Super_start = _Total;
+				_Supers[block / _Blocks_per_super] = _Total;
+			}
+			_Blocks[block] = static_cast<uint16_t>(_Total - _Super_start);
+
+			const size_t _Begin = block * _Words_per_block;
+			const size_t _End = _Begin + _Words_per_block < _Words.size() ? _Begin + _Words_per_block : _Words.size();
+			const size_t _In_block = _Begin < _End ? _DETAIL _Popcount_words(_Words.data() + _Begin, _End - _Begin) : 0;
+
+			// every sampled one that falls inside of this block.
+			while (_Samples.size() * BitVectorView::SelectSampleRate < _Total + _In_block)
+				_Samples.push_back(block);
+			_Total += _In_block;
+		}
+
+		_Ones = _Total;
+		_Indexed = true;
+	}
+
+	// Requires build_index(), the view is invalidated by any modification.
+	_NODISCARD inline BitVectorView view() const noexcept {
+		panic(IF(!_Indexed), "DynamicBitVector: build_index() must be called before rank/select.");
+		return BitVectorView(_Words.data(), _Bits, _Ones, _Supers.data(), _Blocks.data(), _Blocks.size(),
+			_Samples.data(), _Samples.size());
+	}
+
+	_NODISCARD inline size_t rank(size_t pos) const noexcept {
+		return view().rank(pos);
+	}
+	_NODISCARD inline size_t rank0(size_t pos) const noexcept {
+		return view().rank0(pos);
+	}
+	_NODISCARD inline size_t select(size_t k) const noexcept {
+		return view().select(k);
+	}
+
+	// Bytes needed by serialize(), requires build_index().
+	_NODISCARD inline size_t serialized_size() const noexcept {
+		return BitVectorView::serialized_size(_Words.size(), _Supers.size(), _Blocks.size(), _Samples.size());
+	}
+
+	/// <summary>
+	/// Write the bits and the index as one flat, 8 byte aligned image (native byte order) that
+	/// BitVectorView::from_bytes can use in place. `out` must hold serialized_size() bytes.
+	/// </summary>
+	inline size_t serialize(void* out) const noexcept {
+		panic(IF(!_Indexed), "DynamicBitVector: build_index() must be called before serialize().");
+		const uint64 _Head[7] = { BitVectorView::Magic, _Bits, _Ones, _Words.size(), _Supers.size(), _Blocks.size(), _Samples.size() };
+		auto* _Out = static_cast<uint8_t*>(out);
+		std::memcpy(_Out, _Head, sizeof(_Head));
+		_Out += sizeof(_Head);
+		std::memcpy(_Out, _Words.data(), _Words.size() * 8);
+		_Out += _Words.size() * 8;
+		std::memcpy(_Out, _Supers.data(), _Supers.size() * 8);
+		_Out += _Supers.size() * 8;
+		const size_t _Block_bytes = BitVectorView::_Padded_block_bytes(_Blocks.size());
+		std::memset(_Out, 0, _Block_bytes);
+		std::memcpy(_Out, _Blocks.data(), _Blocks.size() * sizeof(uint16_t));
+		_Out += _Block_bytes;
+		std::memcpy(_Out, _Samples.data(), _Samples.size() * 8);
+		_Out += _Samples.size() * 8;
+		return static_cast<size_t>(_Out - static_cast<uint8_t*>(out));
+	}
+
+private:
+	inline void _Clear_tail() noexcept {
+		if (_Bits % 64 && !_Words.empty())
+			_Words.back() &= (uint64{ 1 } << (_Bits % 64)) - 1;
 	}
 };
 
-_STD_API_END
\ No newline at end of file
+_STD_API_END
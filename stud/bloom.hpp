@@ -0,0 +1,255 @@
+
+#ifndef _STD_BLOOM
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+#include "forward.hpp"
+#include "stddef.hpp"
+#include "result.hpp"
+#include "bits.hpp"
+#include "hash.hpp"
+
+_STD_API_BEGIN
+
+enum class BloomFilterError {
+    // Only filters built with the same size (and hasher) can be merged.
+    ShapeMismatch,
+};
+
+_STD_API_END
+
+_STD_DETAIL_API
+
+// Bits per item for a classic bloom filter with false positive rate `fpp`: -ln(p) / ln(2)^2
+_STD_INLINE float64 _Bloom_bits_per_item(float64 fpp) noexcept {
+    if (fpp <= 0.0)
+        fpp = 1e-9;
+    if (fpp >= 1.0)
+        fpp = 0.5;
+    return -std::log(fpp) / (0.6931471805599453 * 0.6931471805599453);
+}
+
+_STD_API_END
+
+_STD_API_BEGIN
+
+/// <summary>
+/// A classic bloom filter over a DynamicBitVector, k probes spread across the whole array
+/// (double hashing). Smallest for a given false positive rate, but every probe is a potential
+/// cache miss, prefer BlockedBloomFilter when lookups are hot.
+/// </summary>
+template <class Hasher = DefaultHasher>
+class BloomFilter {
+private:
+    DynamicBitVector _Bits;
+    size_t _Probes{ 1 };
+    Hasher _Hasher;
+public:
+    inline BloomFilter(size_t bits, size_t probes, Hasher hasher = Hasher{}) noexcept
+        : _Bits(bits < 64 ? 64 : bits)
+        , _Probes(probes == 0 ? 1 : probes)
+        , _Hasher(hasher)
+    {}
+
+    // Sized for `expected_items` insertions at a false positive rate of `fpp`.
+    _NODISCARD inline static BloomFilter with_capacity(size_t expected_items, float64 fpp, Hasher hasher = Hasher{}) noexcept {
+        const float64 _Per_item = _DETAIL _Bloom_bits_per_item(fpp);
+        const auto _Bits = static_cast<size_t>(std::ceil(_Per_item * static_cast<float64>(expected_items ? expected_items : 1)));
+        const auto _Probes = static_cast<size_t>(std::lround(_Per_item * 0.6931471805599453));
+        return BloomFilter(_Bits, _Probes, hasher);
+    }
+
+    inline void insert_hash(uint64 hash) noexcept {
+        const uint64 _Step = (hash >> 32) | 1;
+        const size_t _Size = _Bits.size();
+        uint64 _Probe = hash;
+        for (size_t i = 0; i < _Probes; ++i, _Probe += _Step)
+            _Bits.set(static_cast<size_t>(_Probe % _Size));
+    }
+
+    _NODISCARD inline bool contains_hash(uint64 hash) const noexcept {
+        const uint64 _Step = (hash >> 32) | 1;
+        const size_t _Size = _Bits.size();
+        uint64 _Probe = hash;
+        for (size_t i = 0; i < _Probes; ++i, _Probe += _Step) {
+            if (!_Bits.test(static_cast<size_t>(_Probe % _Size)))
+                return false;
+        }
+        return true;
+    }
+
+    template <class T>
+    inline void insert(const T& key) noexcept {
+        insert_hash(_Hasher(key));
+    }
+    template <class T>
+    _NODISCARD inline bool contains(const T& key) const noexcept {
+        return contains_hash(_Hasher(key));
+    }
+
+    // Union with a filter of the same shape, e.g one filled on another thread.
+    inline Result<placeholder, BloomFilterError> merge(const BloomFilter& other) noexcept {
+        if (other._Bits.size() != _Bits.size() || other._Probes != _Probes)
+            return BloomFilterError::ShapeMismatch;
+        _Bits |= other._Bits;
+        return placeholder{};
+    }
+
+    _NODISCARD inline size_t bit_count() const noexcept {
+        return _Bits.size();
+    }
+    _NODISCARD inline size_t probe_count() const noexcept {
+        return _Probes;
+    }
+};
+
+/// <summary>
+/// A split block bloom filter: each key maps to one 256 bit block (a single cache line access)
+/// and sets one bit in each of the block's eight 32 bit words. The eight bit positions come from
+/// multiplying the key by eight odd salts, which AVX2 does in one instruction, so a probe is
+/// a multiply, a shift, a variable shift and one vptest.
+///
+/// Each block is a BitSet&lt;256&gt;, 32 byte aligned, with 32 bit word i holding bits [32i, 32i + 32).
+///
+/// Costs roughly 10-20% more bits than a classic filter for the same false positive rate.
+/// </summary>
+template <class Hasher = DefaultHasher>
+class BlockedBloomFilter {
+public:
+    static constexpr size_t BlockBits = 256;
+private:
+    using _Block = BitSet<BlockBits>;
+    static_assert(sizeof(_Block) == BlockBits / 8 && alignof(_Block) >= 32, "a block must be exactly one aligned 256 bit load.");
+
+    static constexpr uint32 _Salts[8] = {
+        0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+        0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u,
+    };
+
+    std::vector<_Block> _Blocks;
+    Hasher _Hasher;
+
+    _NODISCARD inline size_t _Block_index(uint64 hash) const noexcept {
+        // multiply-shift instead of a modulo, the upper half of the hash picks the block.
+        return static_cast<size_t>(((hash >> 32) * static_cast<uint64>(_Blocks.size())) >> 32);
+    }
+public:
+    inline explicit BlockedBloomFilter(size_t blocks, Hasher hasher = Hasher{}) noexcept
+        : _Blocks(blocks == 0 ? 1 : blocks, _Block{})
+        , _Hasher(hasher)
+    {}
+
+    // Sized for `expected_items` insertions at a false positive rate of `fpp`.
+    _NODISCARD inline static BlockedBloomFilter with_capacity(size_t expected_items, float64 fpp, Hasher hasher = Hasher{}) noexcept {
+        // blocking skews the load between blocks, pay for it with a little extra space.
+        const float64 _Per_item = _DETAIL _Bloom_bits_per_item(fpp) * 1.2;
+        const float64 _Bits = _Per_item * static_cast<float64>(expected_items ? expected_items : 1);
+        return BlockedBloomFilter(static_cast<size_t>(std::ceil(_Bits / BlockBits)), hasher);
+    }
+
+    inline void insert_hash(uint64 hash) noexcept {
+        auto& _Target = _Blocks[_Block_index(hash)];
+        const auto _Key = static_cast<uint32>(hash);
+#if defined(__AVX2__)
+        const __m256i _Mask = _Make_mask(_Key);
+        const __m256i _Current = _mm256_load_si256(reinterpret_cast<const __m256i*>(_Target.words()));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(_Target.words()), _mm256_or_si256(_Current, _Mask));
+#else
+        for (size_t i = 0; i < 8; ++i)
+            _Target.set(i * 32 + ((_Key * _Salts[i]) >> 27));
+#endif
+    }
+
+    _NODISCARD inline bool contains_hash(uint64 hash) const noexcept {
+        const auto& _Target = _Blocks[_Block_index(hash)];
+        const auto _Key = static_cast<uint32>(hash);
+#if defined(__AVX2__)
+        const __m256i _Mask = _Make_mask(_Key);
+        const __m256i _Current = _mm256_load_si256(reinterpret_cast<const __m256i*>(_Target.words()));
+        // testc: (~current & mask) == 0
+        return _mm256_testc_si256(_Current, _Mask) != 0;
+#else
+        const uint64* _Words = _Target.words();
+        uint64 _Missing = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            const size_t _Bit = i * 32 + ((_Key * _Salts[i]) >> 27);
+            _Missing |= ~_Words[_Bit / 64] & (uint64{ 1 } << (_Bit % 64));
+        }
+        return _Missing == 0;
+#endif
+    }
+
+    /// <summary>
+    /// Probe many hashes at once, out[i] = contains_hash(hashes[i]). Blocks are prefetched
+    /// a few keys ahead so the cache misses overlap.
+    /// </summary>
+    inline void contains_hashes(const uint64* hashes, size_t count, bool* out) const noexcept {
+        constexpr size_t _Distance = 8;
+        for (size_t i = 0; i < count; ++i) {
+            if (i + _Distance < count) {
+#if defined(__GNUC__) || defined(__clang__)
+                __builtin_prefetch(&_Blocks[_Block_index(hashes[i + _Distance])]);
+#elif defined(_M_X64) || defined(_M_IX86)
+                _mm_prefetch(reinterpret_cast<const char*>(&_Blocks[_Block_index(hashes[i + _Distance])]), _MM_HINT_T0);
+#endif
+            }
+            out[i] = contains_hash(hashes[i]);
+        }
+    }
+
+    template <class T>
+    inline void insert(const T& key) noexcept {
+        insert_hash(_Hasher(key));
+    }
+    template <class T>
+    _NODISCARD inline bool contains(const T& key) const noexcept {
+        return contains_hash(_Hasher(key));
+    }
+
+    /// <summary>
+    /// Union with a filter of the same shape. Filters filled independently on different threads
+    /// can be merged into one, the result is identical to inserting every key into a single filter.
+    /// </summary>
+    inline Result<placeholder, BloomFilterError> merge(const BlockedBloomFilter& other) noexcept {
+        if (other._Blocks.size() != _Blocks.size())
+            return BloomFilterError::ShapeMismatch;
+        for (size_t index = 0; index < _Blocks.size(); ++index)
+            _Blocks[index] |= other._Blocks[index];
+        return placeholder{};
+    }
+
+    inline void clear() noexcept {
+        std::fill(_Blocks.begin(), _Blocks.end(), _Block{});
+    }
+
+    _NODISCARD inline size_t block_count() const noexcept {
+        return _Blocks.size();
+    }
+    _NODISCARD inline size_t bit_count() const noexcept {
+        return _Blocks.size() * BlockBits;
+    }
+
+private:
+#if defined(__AVX2__)
+    static inline __m256i _Make_mask(uint32 key) noexcept {
+        const __m256i _Salt = _mm256_setr_epi32(
+            static_cast<int>(_Salts[0]), static_cast<int>(_Salts[1]), static_cast<int>(_Salts[2]), static_cast<int>(_Salts[3]),
+            static_cast<int>(_Salts[4]), static_cast<int>(_Salts[5]), static_cast<int>(_Salts[6]), static_cast<int>(_Salts[7]));
+        __m256i _Bits = _mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(key)), _Salt);
+        _Bits = _mm256_srli_epi32(_Bits, 27);
+        return _mm256_sllv_epi32(_mm256_set1_epi32(1), _Bits);
+    }
+#endif
+};
+
+_STD_API_END
+
+#define _STD_BLOOM
+#endif
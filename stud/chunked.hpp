@@ -0,0 +1,250 @@
+
+#ifndef _STD_CHUNKED
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdlib>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "forward.hpp"
+#include "stddef.hpp"
+#include "panic.hpp"
+#include "iterator.hpp"
+
+_STD_API_BEGIN
+
+/// <summary>
+/// A growable array of fixed size chunks that never moves an element: growing allocates
+/// another chunk and records it in the chunk directory, so pointers and references stay
+/// valid for the lifetime of the element. Element i is chunk (i >> shift), slot (i & mask).
+///
+/// The directory is itself split into blocks of doubling size that are never reallocated,
+/// which lets appends run from any number of threads at once: each append reserves its
+/// index with one atomic add, and chunks are published with a compare-exchange. Reading an
+/// element appended by another thread needs the usual happens-before with that thread
+/// (a join, a release/acquire flag). pop_back(), clear() and the copy and move operations
+/// are single threaded.
+/// </summary>
+template <class T, size_t ChunkSize = _DETAIL _Segment_size<T>>
+class ChunkedVector {
+    static_assert(std::has_single_bit(ChunkSize), "ChunkedVector: the chunk size must be a power of two.");
+    static_assert(alignof(T) <= alignof(std::max_align_t), "ChunkedVector chunks come from malloc, over-aligned types are not supported.");
+public:
+    using value_type = T;
+    using iterator = _DETAIL _Index_iterator<ChunkedVector, T>;
+    using const_iterator = _DETAIL _Index_iterator<const ChunkedVector, const T>;
+
+    static constexpr size_t chunk_size = ChunkSize;
+private:
+    static constexpr size_t _Shift = std::countr_zero(ChunkSize);
+    static constexpr size_t _Mask = ChunkSize - 1;
+    // directory block b holds (16 << b) chunk pointers.
+    static constexpr size_t _First_block = 16;
+    static constexpr size_t _Block_shift = 4;
+    static constexpr size_t _Max_blocks = 48;
+
+    std::atomic<std::atomic<T*>*> _Blocks[_Max_blocks]{};
+    std::atomic<size_t> _Size{ 0 };
+public:
+    ChunkedVector() noexcept = default;
+    inline ChunkedVector(std::initializer_list<T> init) noexcept {
+        for (const auto& element : init)
+            push_back(element);
+    }
+    inline ChunkedVector(const ChunkedVector& other) noexcept {
+        for (const auto& element : other)
+            push_back(element);
+    }
+    inline ChunkedVector(ChunkedVector&& other) noexcept {
+        swap(other);
+    }
+    inline ChunkedVector& operator=(const ChunkedVector& other) noexcept {
+        if (this != &other) {
+            ChunkedVector _Copy(other);
+            swap(_Copy);
+        }
+        return *this;
+    }
+    inline ChunkedVector& operator=(ChunkedVector&& other) noexcept {
+        if (this != &other) {
+            ChunkedVector _Moved(std::move(other));
+            swap(_Moved);
+        }
+        return *this;
+    }
+    inline ~ChunkedVector() noexcept {
+        clear();
+        for (size_t block = 0; block < _Max_blocks; ++block) {
+            auto* _Block = _Blocks[block].load(std::memory_order_relaxed);
+            if (_Block == nullptr)
+                continue;
+            for (size_t slot = 0; slot < (_First_block << block); ++slot)
+                ::free(_Block[slot].load(std::memory_order_relaxed));
+            ::free(_Block);
+        }
+    }
+
+    // Safe to call from several threads at once.
+    inline T& push_back(T&& value) noexcept {
+        return emplace_back(std::move(value));
+    }
+    inline T& push_back(const T& value) noexcept {
+        return emplace_back(value);
+    }
+
+    // Safe to call from several threads at once.
+    template <typename... Ts>
+    inline T& emplace_back(Ts&&... args) noexcept {
+        const size_t _Index = _Size.fetch_add(1, std::memory_order_relaxed);
+        return *::new (static_cast<void*>(_Slot(_Index))) T(std::forward<Ts>(args)...);
+    }
+
+    /// <summary>
+    /// Appends `count` value initialized elements and returns the index of the first, for
+    /// producers that fill a block of their own. Safe to call from several threads at once.
+    /// </summary>
+    inline size_t grow_by(size_t count) noexcept {
+        const size_t _First = _Size.fetch_add(count, std::memory_order_relaxed);
+        for (size_t index = _First; index < _First + count; ++index)
+            ::new (static_cast<void*>(_Slot(index))) T();
+        return _First;
+    }
+
+    // The chunk stays allocated for the next append.
+    inline void pop_back() noexcept {
+        const size_t _Count = _Size.load(std::memory_order_relaxed);
+        panic(IF(_Count == 0), "cannot pop_back an empty ChunkedVector.");
+        (*this)[_Count - 1].~T();
+        _Size.store(_Count - 1, std::memory_order_relaxed);
+    }
+
+    // Destroys every element, keeping the chunks.
+    inline void clear() noexcept {
+        const size_t _Count = _Size.load(std::memory_order_relaxed);
+        for (size_t index = 0; index < _Count; ++index)
+            (*this)[index].~T();
+        _Size.store(0, std::memory_order_relaxed);
+    }
+
+    _NODISCARD inline T& operator[](size_t index) noexcept {
+        return _Chunk(index >> _Shift)[index & _Mask];
+    }
+    _NODISCARD inline const T& operator[](size_t index) const noexcept {
+        return _Chunk(index >> _Shift)[index & _Mask];
+    }
+    _NODISCARD inline T& at(size_t index) noexcept {
+        panic(IF(index >= size()), "ChunkedVector::at(): index {} is out of range for size {}.", index, size());
+        return (*this)[index];
+    }
+    _NODISCARD inline const T& at(size_t index) const noexcept {
+        panic(IF(index >= size()), "ChunkedVector::at(): index {} is out of range for size {}.", index, size());
+        return (*this)[index];
+    }
+
+    _NODISCARD inline T& front() noexcept {
+        return at(0);
+    }
+    _NODISCARD inline const T& front() const noexcept {
+        return at(0);
+    }
+    _NODISCARD inline T& back() noexcept {
+        return at(size() - 1);
+    }
+    _NODISCARD inline const T& back() const noexcept {
+        return at(size() - 1);
+    }
+
+    // Includes elements other threads have reserved but may still be constructing.
+    _NODISCARD inline size_t size() const noexcept {
+        return _Size.load(std::memory_order_acquire);
+    }
+    _NODISCARD inline bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    // Calls fn(T*, count) for each chunk's run of elements, in order.
+    template <class Fn>
+    inline void for_each_chunk(Fn&& fn) {
+        const size_t _Count = size();
+        for (size_t first = 0; first < _Count; first += ChunkSize)
+            fn(&(*this)[first], std::min(ChunkSize, _Count - first));
+    }
+
+    _NODISCARD inline iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+    _NODISCARD inline iterator end() noexcept {
+        return iterator(this, size());
+    }
+    _NODISCARD inline const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+    _NODISCARD inline const_iterator end() const noexcept {
+        return const_iterator(this, size());
+    }
+
+    inline void swap(ChunkedVector& other) noexcept {
+        for (size_t block = 0; block < _Max_blocks; ++block) {
+            auto* _Mine = _Blocks[block].load(std::memory_order_relaxed);
+            _Blocks[block].store(other._Blocks[block].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            other._Blocks[block].store(_Mine, std::memory_order_relaxed);
+        }
+        const size_t _Mine = _Size.load(std::memory_order_relaxed);
+        _Size.store(other._Size.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other._Size.store(_Mine, std::memory_order_relaxed);
+    }
+    friend inline void swap(ChunkedVector& left, ChunkedVector& right) noexcept {
+        left.swap(right);
+    }
+
+private:
+    // Where chunk `chunk` is recorded: its directory block and the slot inside it.
+    _NODISCARD static constexpr std::pair<size_t, size_t> _Locate(size_t chunk) noexcept {
+        const size_t _Block = std::bit_width((chunk >> _Block_shift) + 1) - 1;
+        return { _Block, chunk - _First_block * ((size_t{ 1 } << _Block) - 1) };
+    }
+
+    _NODISCARD inline T* _Chunk(size_t chunk) const noexcept {
+        const auto [_Block, _Entry] = _Locate(chunk);
+        return _Blocks[_Block].load(std::memory_order_acquire)[_Entry].load(std::memory_order_acquire);
+    }
+
+    // The storage for element `index`, publishing its directory block and chunk if this
+    // is the first append to reach them. Racing threads allocate, one wins the exchange.
+    _NODISCARD inline T* _Slot(size_t index) noexcept {
+        const auto [_Block, _Entry] = _Locate(index >> _Shift);
+        panic(IF(_Block >= _Max_blocks), "ChunkedVector: limit exceeded.");
+
+        auto* _Directory = _Blocks[_Block].load(std::memory_order_acquire);
+        if (_Directory == nullptr) {
+            auto* _New = static_cast<std::atomic<T*>*>(::malloc(sizeof(std::atomic<T*>) * (_First_block << _Block)));
+            panic(IF(_New == nullptr), "ChunkedVector: failed to allocate the chunk directory.");
+            std::uninitialized_value_construct_n(_New, _First_block << _Block);
+            if (_Blocks[_Block].compare_exchange_strong(_Directory, _New, std::memory_order_acq_rel, std::memory_order_acquire))
+                _Directory = _New;
+            else
+                ::free(_New);
+        }
+
+        T* _Chunk_ptr = _Directory[_Entry].load(std::memory_order_acquire);
+        if (_Chunk_ptr == nullptr) {
+            auto* _New = static_cast<T*>(::malloc(sizeof(T) * ChunkSize));
+            panic(IF(_New == nullptr), "ChunkedVector: failed to allocate a chunk of {} elements.", ChunkSize);
+            if (_Directory[_Entry].compare_exchange_strong(_Chunk_ptr, _New, std::memory_order_acq_rel, std::memory_order_acquire))
+                _Chunk_ptr = _New;
+            else
+                ::free(_New);
+        }
+        return _Chunk_ptr + (index & _Mask);
+    }
+};
+
+_STD_API_END
+
+#define _STD_CHUNKED
+#endif
@@ -0,0 +1,347 @@
+
+#ifndef _STD_EPOCH
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "forward.hpp"
+#include "stddef.hpp"
+#include "panic.hpp"
+
+_STD_DETAIL_API
+
+// A pointer waiting for every thread to leave the epoch it was retired in.
+struct _Retired {
+    void* _Ptr;
+    void (*_Deleter)(void*);
+    uint64 _Epoch;
+};
+
+/// <summary>
+/// One thread's record in an EpochDomain. Records live as long as the domain: a thread
+/// that exits hands its retired pointers to the domain and leaves the record for the
+/// next thread to claim.
+/// </summary>
+struct _Epoch_participant {
+    // the epoch this thread is pinned in, 0 when it holds no Guard.
+    alignas(64) std::atomic<uint64> _Pinned{ 0 };
+    std::atomic<bool> _In_use{ true };
+    _Epoch_participant* _Next{ nullptr };
+
+    // only touched by the owning thread.
+    size_t _Depth{ 0 };
+    size_t _Since_collect{ 0 };
+    std::vector<_Retired> _Bag;
+};
+
+_STD_API_END
+
+_STD_API_BEGIN
+
+/// <summary>
+/// A snapshot of an EpochDomain, for watching how far reclamation is behind.
+/// </summary>
+struct EpochStats {
+    // the global epoch.
+    uint64 epoch;
+    // how many epochs the longest pinned thread is behind, 0 when none is pinned.
+    // Nothing retired since that thread pinned can be freed until it unpins.
+    uint64 lag;
+    // retired and not freed yet.
+    size_t pending;
+    // freed since the domain was created.
+    size_t reclaimed;
+    // threads that have used the domain and not exited.
+    size_t threads;
+};
+
+/// <summary>
+/// Epoch based reclamation for lock-free structures. A thread reads shared nodes inside
+/// a Guard, which pins it to the current global epoch. A node unlinked from the
+/// structure is retired through the Guard instead of being freed:
+///
+///     stud::EpochDomain::Guard guard;
+///     Node* head = _Head.load();
+///     if (_Head.compare_exchange_strong(head, head-&gt;next))
+///         guard.retire(head);
+///
+/// The epoch only advances once every pinned thread has seen it, so a node retired in
+/// epoch e is unreachable by the time the epoch reaches e + 2 and is deleted then.
+/// Each thread keeps its own retire list and frees it in batches every
+/// collect_threshold retirements, so retiring is a push onto a thread-local vector.
+///
+/// A thread pinned for a long time holds back every node retired after it pinned,
+/// stats() reports that as lag. The domain must outlive every Guard on it.
+/// </summary>
+class EpochDomain {
+public:
+    class Guard;
+
+    // Retirements between two attempts to free a thread's retire list.
+    static constexpr size_t collect_threshold = 64;
+private:
+    alignas(64) std::atomic<uint64> _Epoch{ 1 };
+    std::atomic<_DETAIL _Epoch_participant*> _Participants{ nullptr };
+    std::atomic<size_t> _Retired_count{ 0 };
+    std::atomic<size_t> _Reclaimed_count{ 0 };
+
+    // retire lists of threads that exited, freed by whichever thread collects next.
+    std::mutex _Orphan_lock;
+    std::vector<_DETAIL _Retired> _Orphans;
+
+    // tells this domain apart from a later one at the same address.
+    uint64 _Id;
+
+    // This thread's records, one per domain it has used. When the thread exits each
+    // record still belonging to a live domain is given back.
+    struct _Thread_records {
+        struct _Entry {
+            EpochDomain* _Domain;
+            uint64 _Id;
+            _DETAIL _Epoch_participant* _Participant;
+        };
+        std::vector<_Entry> _Entries;
+
+        inline ~_Thread_records() noexcept {
+            std::lock_guard _Lock(_Registry_lock());
+            for (const auto& entry : _Entries) {
+                if (_Is_live(entry._Id))
+                    entry._Domain->_Release(*entry._Participant);
+            }
+        }
+    };
+public:
+    inline EpochDomain() noexcept {
+        static std::atomic<uint64> _Ids{ 0 };
+        _Id = _Ids.fetch_add(1, std::memory_order_relaxed) + 1;
+        std::lock_guard _Lock(_Registry_lock());
+        _Live_domains().push_back(_Id);
+    }
+
+    _STD_MAKE_NONCOPYABLE(EpochDomain);
+    _STD_MAKE_NONMOVEABLE(EpochDomain);
+
+    // Frees everything still retired, no thread may hold a Guard on the domain.
+    inline ~EpochDomain() noexcept {
+        {
+            std::lock_guard _Lock(_Registry_lock());
+            auto& _Live = _Live_domains();
+            _Live.erase(std::find(_Live.begin(), _Live.end(), _Id));
+        }
+        auto* _Participant = _Participants.load(std::memory_order_acquire);
+        while (_Participant) {
+            panic(IF(_Participant->_Pinned.load(std::memory_order_relaxed) != 0),
+                "EpochDomain destroyed while a Guard on it is still alive.");
+            for (const auto& retired : _Participant->_Bag)
+                retired._Deleter(retired._Ptr);
+            delete std::exchange(_Participant, _Participant->_Next);
+        }
+        for (const auto& retired : _Orphans)
+            retired._Deleter(retired._Ptr);
+    }
+
+    // The domain Guard uses by default, for structures that do not bring their own.
+    _NODISCARD static inline EpochDomain& global() noexcept {
+        static EpochDomain _Global;
+        return _Global;
+    }
+
+    _NODISCARD inline uint64 epoch() const noexcept {
+        return _Epoch.load(std::memory_order_relaxed);
+    }
+
+    // Tries to advance the epoch and frees what this thread retired that is now safe.
+    inline void collect() noexcept {
+        auto& _Self = _Local();
+        _Pin(_Self);
+        _Collect(_Self);
+        _Unpin(_Self);
+    }
+
+    _NODISCARD inline EpochStats stats() const noexcept {
+        EpochStats _Stats{};
+        _Stats.epoch = _Epoch.load(std::memory_order_relaxed);
+        for (auto* p = _Participants.load(std::memory_order_acquire); p; p = p->_Next) {
+            if (!p->_In_use.load(std::memory_order_relaxed))
+                continue;
+            ++_Stats.threads;
+            const uint64 _Pinned = p->_Pinned.load(std::memory_order_relaxed);
+            if (_Pinned != 0 && _Pinned < _Stats.epoch)
+                _Stats.lag = std::max(_Stats.lag, _Stats.epoch - _Pinned);
+        }
+        _Stats.reclaimed = _Reclaimed_count.load(std::memory_order_relaxed);
+        const size_t _Retired = _Retired_count.load(std::memory_order_relaxed);
+        _Stats.pending = _Retired > _Stats.reclaimed ? _Retired - _Stats.reclaimed : 0;
+        return _Stats;
+    }
+
+private:
+    _NODISCARD static inline std::mutex& _Registry_lock() noexcept {
+        static std::mutex _Lock;
+        return _Lock;
+    }
+    _NODISCARD static inline std::vector<uint64>& _Live_domains() noexcept {
+        static std::vector<uint64> _Live;
+        return _Live;
+    }
+    // _Registry_lock() must be held.
+    _NODISCARD static inline bool _Is_live(uint64 id) noexcept {
+        const auto& _Live = _Live_domains();
+        return std::find(_Live.begin(), _Live.end(), id) != _Live.end();
+    }
+
+    // This thread's record, claiming a free one or adding one on first use.
+    _NODISCARD inline _DETAIL _Epoch_participant& _Local() noexcept {
+        thread_local _Thread_records _Records;
+        for (const auto& entry : _Records._Entries) {
+            if (entry._Domain == this && entry._Id == _Id)
+                return *entry._Participant;
+        }
+        {
+            // forget domains that no longer exist before this one is added.
+            std::lock_guard _Lock(_Registry_lock());
+            std::erase_if(_Records._Entries, [](const auto& entry) { return !_Is_live(entry._Id); });
+        }
+        auto& _Participant = _Register();
+        _Records._Entries.push_back({ this, _Id, &_Participant });
+        return _Participant;
+    }
+
+    _NODISCARD inline _DETAIL _Epoch_participant& _Register() noexcept {
+        for (auto* p = _Participants.load(std::memory_order_acquire); p; p = p->_Next) {
+            bool _Free = false;
+            if (p->_In_use.compare_exchange_strong(_Free, true, std::memory_order_acquire, std::memory_order_relaxed))
+                return *p;
+        }
+        auto* _New = new _DETAIL _Epoch_participant();
+        _New->_Next = _Participants.load(std::memory_order_relaxed);
+        while (!_Participants.compare_exchange_weak(_New->_Next, _New, std::memory_order_release, std::memory_order_relaxed)) {}
+        return *_New;
+    }
+
+    // Called for a thread that exited, with the registry locked.
+    inline void _Release(_DETAIL _Epoch_participant& self) noexcept {
+        if (!self._Bag.empty()) {
+            std::lock_guard _Lock(_Orphan_lock);
+            _Orphans.insert(_Orphans.end(), self._Bag.begin(), self._Bag.end());
+            self._Bag.clear();
+        }
+        self._Depth = 0;
+        self._Since_collect = 0;
+        self._Pinned.store(0, std::memory_order_release);
+        self._In_use.store(false, std::memory_order_release);
+    }
+
+    // Nested guards share the outermost one's epoch.
+    inline void _Pin(_DETAIL _Epoch_participant& self) noexcept {
+        if (self._Depth++ != 0)
+            return;
+        // a full barrier: the pin must be visible before any shared node is read, see
+        // _Try_advance. Being a read-modify-write it also continues the release sequence
+        // of the last unpin, so an advance that sees this pin still sees the reads that
+        // came before that unpin.
+        DISCARD(self._Pinned.exchange(_Epoch.load(std::memory_order_relaxed), std::memory_order_seq_cst));
+    }
+    inline void _Unpin(_DETAIL _Epoch_participant& self) noexcept {
+        if (--self._Depth == 0)
+            self._Pinned.store(0, std::memory_order_release);
+    }
+
+    // Moves the epoch on by one if every pinned thread is in the current epoch.
+    inline bool _Try_advance() noexcept {
+        uint64 _Current = _Epoch.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (auto* p = _Participants.load(std::memory_order_acquire); p; p = p->_Next) {
+            // acquire: every read a thread made before unpinning happens before the advance.
+            const uint64 _Pinned = p->_Pinned.load(std::memory_order_acquire);
+            if (_Pinned != 0 && _Pinned != _Current)
+                return false;
+        }
+        return _Epoch.compare_exchange_strong(_Current, _Current + 1, std::memory_order_release, std::memory_order_relaxed);
+    }
+
+    inline void _Retire(_DETAIL _Epoch_participant& self, void* ptr, void (*deleter)(void*)) noexcept {
+        // the epoch is read after the node was unlinked, never before.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        self._Bag.push_back({ ptr, deleter, _Epoch.load(std::memory_order_relaxed) });
+        _Retired_count.fetch_add(1, std::memory_order_relaxed);
+        if (++self._Since_collect >= collect_threshold)
+            _Collect(self);
+    }
+
+    inline void _Collect(_DETAIL _Epoch_participant& self) noexcept {
+        self._Since_collect = 0;
+        _Try_advance();
+        const uint64 _Current = _Epoch.load(std::memory_order_acquire);
+
+        // deleters run last: one may retire again, which would grow the list being walked.
+        std::vector<_DETAIL _Retired> _Expired;
+        _Take_expired(self._Bag, _Current, _Expired);
+        if (_Orphan_lock.try_lock()) {
+            _Take_expired(_Orphans, _Current, _Expired);
+            _Orphan_lock.unlock();
+        }
+        for (const auto& retired : _Expired)
+            retired._Deleter(retired._Ptr);
+        _Reclaimed_count.fetch_add(_Expired.size(), std::memory_order_relaxed);
+    }
+
+    // Moves the entries of `bag` retired two or more epochs before `current` into `expired`.
+    static inline void _Take_expired(std::vector<_DETAIL _Retired>& bag, uint64 current, std::vector<_DETAIL _Retired>& expired) noexcept {
+        auto _Kept = std::partition(bag.begin(), bag.end(), [current](const _DETAIL _Retired& retired) {
+            return retired._Epoch + 2 > current;
+        });
+        expired.insert(expired.end(), _Kept, bag.end());
+        bag.erase(_Kept, bag.end());
+    }
+};
+
+/// <summary>
+/// Pins the calling thread to the domain's epoch for its lifetime. Shared nodes read
+/// inside the Guard stay allocated until it is destroyed, even if another thread retires
+/// them meanwhile. Guards nest and belong to the thread that made them.
+/// </summary>
+class EpochDomain::Guard {
+private:
+    EpochDomain& _Domain;
+    _DETAIL _Epoch_participant& _Self;
+public:
+    inline explicit Guard(EpochDomain& domain = EpochDomain::global()) noexcept
+        : _Domain(domain), _Self(domain._Local())
+    {
+        _Domain._Pin(_Self);
+    }
+    inline ~Guard() noexcept {
+        _Domain._Unpin(_Self);
+    }
+
+    _STD_MAKE_NONCOPYABLE(Guard);
+    _STD_MAKE_NONMOVEABLE(Guard);
+
+    // Deletes `ptr` once no thread can still be reading it. It must already be unlinked.
+    template <class T>
+    inline void retire(T* ptr) noexcept {
+        _Domain._Retire(_Self, ptr, [](void* erased) { delete static_cast<T*>(erased); });
+    }
+    inline void retire(void* ptr, void (*deleter)(void*)) noexcept {
+        _Domain._Retire(_Self, ptr, deleter);
+    }
+
+    _NODISCARD inline EpochDomain& domain() const noexcept {
+        return _Domain;
+    }
+
+    // The epoch this thread is pinned in.
+    _NODISCARD inline uint64 epoch() const noexcept {
+        return _Self._Pinned.load(std::memory_order_relaxed);
+    }
+};
+
+_STD_API_END
+
+#define _STD_EPOCH
+#endif
@@ -0,0 +1,304 @@
+
+#ifndef _STD_FLATMAP
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <span>
+#include <utility>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+#include "forward.hpp"
+#include "stddef.hpp"
+#include "panic.hpp"
+#include "vector.hpp"
+#include "algorithm.hpp"
+
+_STD_DETAIL_API
+
+/// <summary>
+/// lower_bound without a data dependent branch: the loop runs log2(n) times whatever the
+/// keys are, and the compare becomes a conditional move. Both possible next midpoints are
+/// prefetched so large tables overlap their cache misses.
+/// </summary>
+template <class K, class Q, class Compare>
+_STD_INLINE size_t _Branchless_lower_bound(const K* first, size_t count, const Q& key, const Compare& compare) noexcept {
+    if (count == 0)
+        return 0;
+    const K* _Base = first;
+    while (count > 1) {
+        const size_t _Half = count / 2;
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(_Base + _Half / 2);
+        __builtin_prefetch(_Base + _Half + _Half / 2);
+#elif defined(_M_X64) || defined(_M_IX86)
+        _mm_prefetch(reinterpret_cast<const char*>(_Base + _Half / 2), _MM_HINT_T0);
+        _mm_prefetch(reinterpret_cast<const char*>(_Base + _Half + _Half / 2), _MM_HINT_T0);
+#endif
+        _Base = compare(_Base[_Half], key) ? _Base + _Half : _Base;
+        count -= _Half;
+    }
+    return static_cast<size_t>(_Base - first) + (compare(*_Base, key) ? 1 : 0);
+}
+
+// Sort by key, keeping the first of any duplicates, then drop the rest.
+template <class Entry, class Key, class Compare>
+_STD_INLINE void _Sort_unique(Vector<Entry>& entries, const Key& key_of, const Compare& compare) noexcept {
+    std::stable_sort(entries.begin(), entries.end(), [&](const Entry& left, const Entry& right) {
+        return compare(key_of(left), key_of(right));
+    });
+    auto* _End = std::unique(entries.begin(), entries.end(), [&](const Entry& left, const Entry& right) {
+        return !compare(key_of(left), key_of(right));
+    });
+    entries.erase(_End, entries.end());
+}
+
+_STD_API_END
+
+_STD_API_BEGIN
+
+/// <summary>
+/// A sorted set in one contiguous Vector. Built in bulk (one sort, one dedupe) it is the
+/// smallest and most cache friendly set for tables that are read far more than written.
+/// Single inserts and erases are O(n).
+/// </summary>
+template <class K, class Compare = std::less<>>
+class FlatSet {
+private:
+    Vector<K> _Keys;
+    [[no_unique_address]] Compare _Compare;
+
+    struct _Identity {
+        _STD_API const K& operator()(const K& key) const noexcept { return key; }
+    };
+public:
+    FlatSet() noexcept = default;
+    inline explicit FlatSet(Vector<K> keys, Compare compare = Compare{}) noexcept
+        : _Keys(std::move(keys)), _Compare(std::move(compare))
+    {
+        _DETAIL _Sort_unique(_Keys, _Identity{}, _Compare);
+    }
+    inline FlatSet(std::initializer_list<K> keys) noexcept
+        : FlatSet(Vector<K>(keys))
+    {}
+
+    template <class Q>
+    _NODISCARD inline bool contains(const Q& key) const noexcept {
+        const size_t _Index = _Lower_bound(key);
+        return _Index != _Keys.size() && !_Compare(key, _Keys[_Index]);
+    }
+
+    // Index of `key` in view(), or size() when absent.
+    template <class Q>
+    _NODISCARD inline size_t index_of(const Q& key) const noexcept {
+        const size_t _Index = _Lower_bound(key);
+        return _Index != _Keys.size() && !_Compare(key, _Keys[_Index]) ? _Index : _Keys.size();
+    }
+
+    // Returns false if the key was already present.
+    inline bool insert(K key) noexcept {
+        const size_t _Index = _Lower_bound(key);
+        if (_Index != _Keys.size() && !_Compare(key, _Keys[_Index]))
+            return false;
+        _Keys.insert(_Keys.begin() + _Index, std::move(key));
+        return true;
+    }
+
+    template <class Q>
+    inline bool erase(const Q& key) noexcept {
+        const size_t _Index = index_of(key);
+        if (_Index == _Keys.size())
+            return false;
+        _Keys.erase(_Keys.begin() + _Index);
+        return true;
+    }
+
+    inline void reserve(size_t count) noexcept {
+        _Keys.reserve(count);
+    }
+    inline void clear() noexcept {
+        _Keys.clear();
+    }
+
+    _NODISCARD inline size_t size() const noexcept {
+        return _Keys.size();
+    }
+    _NODISCARD inline bool empty() const noexcept {
+        return _Keys.empty();
+    }
+
+    // The keys, sorted.
+    _NODISCARD inline std::span<const K> view() const noexcept {
+        return { _Keys.data(), _Keys.size() };
+    }
+    _NODISCARD inline const K* begin() const noexcept {
+        return _Keys.begin();
+    }
+    _NODISCARD inline const K* end() const noexcept {
+        return _Keys.end();
+    }
+
+private:
+    template <class Q>
+    _NODISCARD inline size_t _Lower_bound(const Q& key) const noexcept {
+        return _DETAIL _Branchless_lower_bound(_Keys.data(), _Keys.size(), key, _Compare);
+    }
+};
+
+/// <summary>
+/// A sorted map over two parallel Vectors, one of keys and one of values. Searches only
+/// walk the packed keys, so a lookup touches log2(n) key cache lines and then one value.
+/// Built in bulk from unsorted entries: one sort, duplicates keep their first value.
+/// Single inserts and erases are O(n).
+///
+/// With the default std::less<> lookups accept any type comparable with K (string_view for
+/// std::string keys).
+/// </summary>
+template <class K, class V, class Compare = std::less<>>
+class FlatMap {
+public:
+    using entry_type = pair<K, V>;
+private:
+    Vector<K> _Keys;
+    Vector<V> _Values;
+    [[no_unique_address]] Compare _Compare;
+
+    struct _Key_of {
+        _STD_API const K& operator()(const entry_type& entry) const noexcept { return entry.key; }
+    };
+public:
+    FlatMap() noexcept = default;
+    inline explicit FlatMap(Vector<entry_type> entries, Compare compare = Compare{}) noexcept
+        : _Compare(std::move(compare))
+    {
+        _DETAIL _Sort_unique(entries, _Key_of{}, _Compare);
+        _Keys.reserve(entries.size());
+        _Values.reserve(entries.size());
+        for (auto& entry : entries) {
+            _Keys.push_back(std::move(entry.key));
+            _Values.push_back(std::move(entry.value));
+        }
+    }
+    inline FlatMap(std::initializer_list<entry_type> entries) noexcept
+        : FlatMap(Vector<entry_type>(entries))
+    {}
+
+    template <class Q>
+    _NODISCARD inline bool contains(const Q& key) const noexcept {
+        return _Find(key) != _Keys.size();
+    }
+
+    // nullptr when the key is not present.
+    template <class Q>
+    _NODISCARD inline V* get(const Q& key) noexcept {
+        const size_t _Index = _Find(key);
+        return _Index == _Keys.size() ? nullptr : &_Values[_Index];
+    }
+    template <class Q>
+    _NODISCARD inline const V* get(const Q& key) const noexcept {
+        const size_t _Index = _Find(key);
+        return _Index == _Keys.size() ? nullptr : &_Values[_Index];
+    }
+
+    template <class Q>
+    _NODISCARD inline V& at(const Q& key) noexcept {
+        auto* _Value = get(key);
+        panic(IF(_Value == nullptr), "FlatMap::at(): key is not present.");
+        return *_Value;
+    }
+    template <class Q>
+    _NODISCARD inline const V& at(const Q& key) const noexcept {
+        const auto* _Value = get(key);
+        panic(IF(_Value == nullptr), "FlatMap::at(): key is not present.");
+        return *_Value;
+    }
+
+    // Returns false (and leaves the map alone) when the key already exists.
+    inline bool insert(K key, V value) noexcept {
+        const size_t _Index = _Lower_bound(key);
+        if (_Index != _Keys.size() && !_Compare(key, _Keys[_Index]))
+            return false;
+        _Keys.insert(_Keys.begin() + _Index, std::move(key));
+        _Values.insert(_Values.begin() + _Index, std::move(value));
+        return true;
+    }
+
+    inline bool insert_or_assign(K key, V value) noexcept {
+        const size_t _Index = _Lower_bound(key);
+        if (_Index != _Keys.size() && !_Compare(key, _Keys[_Index])) {
+            _Values[_Index] = std::move(value);
+            return false;
+        }
+        _Keys.insert(_Keys.begin() + _Index, std::move(key));
+        _Values.insert(_Values.begin() + _Index, std::move(value));
+        return true;
+    }
+
+    template <class Q>
+    inline bool erase(const Q& key) noexcept {
+        const size_t _Index = _Find(key);
+        if (_Index == _Keys.size())
+            return false;
+        _Keys.erase(_Keys.begin() + _Index);
+        _Values.erase(_Values.begin() + _Index);
+        return true;
+    }
+
+    inline void reserve(size_t count) noexcept {
+        _Keys.reserve(count);
+        _Values.reserve(count);
+    }
+    inline void clear() noexcept {
+        _Keys.clear();
+        _Values.clear();
+    }
+
+    _NODISCARD inline size_t size() const noexcept {
+        return _Keys.size();
+    }
+    _NODISCARD inline bool empty() const noexcept {
+        return _Keys.empty();
+    }
+
+    // The keys, sorted. values()[i] belongs to keys()[i].
+    _NODISCARD inline std::span<const K> keys() const noexcept {
+        return { _Keys.data(), _Keys.size() };
+    }
+    _NODISCARD inline std::span<V> values() noexcept {
+        return { _Values.data(), _Values.size() };
+    }
+    _NODISCARD inline std::span<const V> values() const noexcept {
+        return { _Values.data(), _Values.size() };
+    }
+
+    // Calls fn(key, value) for every entry, in key order.
+    template <class Fn>
+    inline void for_each(Fn&& fn) const {
+        for (size_t index = 0; index < _Keys.size(); ++index)
+            fn(_Keys[index], _Values[index]);
+    }
+    template <class Fn>
+    inline void for_each(Fn&& fn) {
+        for (size_t index = 0; index < _Keys.size(); ++index)
+            fn(std::as_const(_Keys[index]), _Values[index]);
+    }
+
+private:
+    template <class Q>
+    _NODISCARD inline size_t _Lower_bound(const Q& key) const noexcept {
+        return _DETAIL _Branchless_lower_bound(_Keys.data(), _Keys.size(), key, _Compare);
+    }
+    template <class Q>
+    _NODISCARD inline size_t _Find(const Q& key) const noexcept {
+        const size_t _Index = _Lower_bound(key);
+        return _Index != _Keys.size() && !_Compare(key, _Keys[_Index]) ? _Index : _Keys.size();
+    }
+};
+
+_STD_API_END
+
+#define _STD_FLATMAP
+#endif
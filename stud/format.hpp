@@ -0,0 +1,123 @@
+
+#ifndef _STD_FORMAT
+
+#include <algorithm>
+#include <concepts>
+#include <format>
+#include <string>
+#include <type_traits>
+
+#include "forward.hpp"
+#include "concept.hpp"
+
+_STD_DETAIL_API
+
+// Whether std::format can print T itself. Disabled std::formatter specializations are
+// not default constructible, which is what std::formattable checks in the end.
+template <class T>
+concept _Has_std_formatter = std::is_default_constructible_v<std::formatter<std::remove_cvref_t<T>, char>>;
+
+// to_string() has to work on the const element the formatter is handed.
+template <class T>
+concept _Const_to_string = requires(const T& value) {
+    { value.to_string() } -> std::same_as<std::string>;
+};
+
+// What _Element_formatter can print. The container formatters require it of their elements,
+// so a container of something unprintable has no formatter rather than a broken one.
+template <class T>
+concept _Formattable_element = _Has_std_formatter<T> || std::is_pointer_v<T> || std::is_enum_v<T> || _Const_to_string<T>;
+
+/// <summary>
+/// How stud's std::formatter specializations print one element: with its own
+/// std::formatter when it has one (so "{:x}" on a container reaches every element),
+/// pointers by address, otherwise through to_string() or, for enums, the underlying value.
+/// </summary>
+template <_Formattable_element T>
+struct _Element_formatter {
+private:
+    static constexpr bool _Formattable = _Has_std_formatter<T>;
+    static constexpr bool _Pointer = !_Formattable && std::is_pointer_v<T>;
+    static constexpr bool _Enum = !_Formattable && !_Const_to_string<T> && std::is_enum_v<T>;
+
+    using _Printed = std::conditional_t<_Formattable, T,
+        std::conditional_t<_Pointer, const void*,
+        typename std::conditional_t<_Enum, std::underlying_type<T>, std::type_identity<std::string>>::type>>;
+
+    std::formatter<_Printed, char> _Inner;
+public:
+    template <class ParseContext>
+    constexpr auto parse(ParseContext& ctx) {
+        return _Inner.parse(ctx);
+    }
+
+    template <class FormatContext>
+    auto format(const T& value, FormatContext& ctx) const {
+        if constexpr (_Formattable)
+            return _Inner.format(value, ctx);
+        else if constexpr (_Pointer)
+            return _Inner.format(static_cast<const void*>(value), ctx);
+        else if constexpr (_Enum)
+            return _Inner.format(static_cast<_Printed>(value), ctx);
+        else
+            return _Inner.format(value.to_string(), ctx);
+    }
+};
+
+/// <summary>
+/// Prints a range as "[a, b, c]" straight into the format context's output, no
+/// intermediate strings. The format spec applies to each element.
+/// </summary>
+template <class T>
+struct _Sequence_formatter {
+    _Element_formatter<T> _Element;
+
+    template <class ParseContext>
+    constexpr auto parse(ParseContext& ctx) {
+        return _Element.parse(ctx);
+    }
+
+    template <class It, class FormatContext>
+    auto _Format(It first, It last, FormatContext& ctx) const {
+        auto _Out = ctx.out();
+        *_Out++ = '[';
+        for (It it = first; it != last; ++it) {
+            if (it != first) {
+                *_Out++ = ',';
+                *_Out++ = ' ';
+            }
+            ctx.advance_to(_Out);
+            _Out = _Element.format(*it, ctx);
+        }
+        *_Out++ = ']';
+        return _Out;
+    }
+};
+
+/// <summary>
+/// Prints "Name(value)", the spec applying to the value. Used for Option and Result.
+/// </summary>
+template <class T>
+struct _Wrapper_formatter {
+    _Element_formatter<T> _Element;
+
+    template <class ParseContext>
+    constexpr auto parse(ParseContext& ctx) {
+        return _Element.parse(ctx);
+    }
+
+    template <class FormatContext>
+    auto _Format(std::string_view name, const T& value, FormatContext& ctx) const {
+        auto _Out = std::copy(name.begin(), name.end(), ctx.out());
+        *_Out++ = '(';
+        ctx.advance_to(_Out);
+        _Out = _Element.format(value, ctx);
+        *_Out++ = ')';
+        return _Out;
+    }
+};
+
+_STD_API_END
+
+#define _STD_FORMAT
+#endif
@@ -0,0 +1,332 @@
+
+#ifndef _STD_HASH
+
+#include <bit>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <functional>
+
+#if defined(__SSE4_2__) || defined(__AVX__)
+#include <nmmintrin.h>
+#define _STD_HASH_CRC32C_HW 1
+#endif
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+#include "forward.hpp"
+#include "stddef.hpp"
+
+_STD_DETAIL_API
+
+// wyhash (final v4) constants.
+inline constexpr uint64 _Wy_secret[4] = {
+    0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull
+};
+
+// 64x64 -> 128 bit multiply, a = low half, b = high half.
+_STD_API void _Wy_mum(uint64& a, uint64& b) noexcept {
+    if (!std::is_constant_evaluated()) {
+#if defined(__SIZEOF_INT128__)
+        const auto _Product = static_cast<unsigned __int128>(a) * b;
+        a = static_cast<uint64>(_Product);
+        b = static_cast<uint64>(_Product >> 64);
+        return;
+#elif defined(_MSC_VER) && defined(_M_X64)
+        a = _umul128(a, b, &b);
+        return;
+#endif
+    }
+    const uint64 _A_lo = a & 0xFFFFFFFF, _A_hi = a >> 32;
+    const uint64 _B_lo = b & 0xFFFFFFFF, _B_hi = b >> 32;
+    const uint64 _Lo_lo = _A_lo * _B_lo;
+    const uint64 _Hi_lo = _A_hi * _B_lo;
+    const uint64 _Lo_hi = _A_lo * _B_hi;
+    const uint64 _Hi_hi = _A_hi * _B_hi;
+    const uint64 _Cross = (_Lo_lo >> 32) + (_Hi_lo & 0xFFFFFFFF) + _Lo_hi;
+    a = (_Cross << 32) | (_Lo_lo & 0xFFFFFFFF);
+    b = (_Hi_lo >> 32) + (_Cross >> 32) + _Hi_hi;
+}
+
+_STD_API uint64 _Wy_mix(uint64 a, uint64 b) noexcept {
+    _Wy_mum(a, b);
+    return a ^ b;
+}
+
+// Little endian reads, byte by byte during constant evaluation.
+_STD_API uint64 _Wy_read8(const char* p) noexcept {
+    if (std::is_constant_evaluated()) {
+        uint64 _Value = 0;
+        for (size_t i = 0; i < 8; ++i)
+            _Value |= static_cast<uint64>(static_cast<unsigned char>(p[i])) << (i * 8);
+        return _Value;
+    }
+    uint64 _Value;
+    std::memcpy(&_Value, p, sizeof(_Value));
+    if constexpr (std::endian::native == std::endian::big)
+        _Value = std::byteswap(_Value);
+    return _Value;
+}
+_STD_API uint64 _Wy_read4(const char* p) noexcept {
+    if (std::is_constant_evaluated()) {
+        uint64 _Value = 0;
+        for (size_t i = 0; i < 4; ++i)
+            _Value |= static_cast<uint64>(static_cast<unsigned char>(p[i])) << (i * 8);
+        return _Value;
+    }
+    uint32 _Value;
+    std::memcpy(&_Value, p, sizeof(_Value));
+    if constexpr (std::endian::native == std::endian::big)
+        _Value = std::byteswap(_Value);
+    return _Value;
+}
+// 1 to 3 bytes, all of them read.
+_STD_API uint64 _Wy_read3(const char* p, size_t length) noexcept {
+    return (static_cast<uint64>(static_cast<unsigned char>(p[0])) << 16)
+        | (static_cast<uint64>(static_cast<unsigned char>(p[length >> 1])) << 8)
+        | static_cast<uint64>(static_cast<unsigned char>(p[length - 1]));
+}
+
+// CRC32C (Castagnoli, reflected polynomial 0x82F63B78), for when SSE4.2 is not available.
+inline constexpr auto _Crc32c_table = []() {
+    struct {
+        uint32 entries[256];
+    } _Table{};
+    for (uint32 byte = 0; byte < 256; ++byte) {
+        uint32 _Crc = byte;
+        for (int bit = 0; bit < 8; ++bit)
+            _Crc = (_Crc >> 1) ^ (0x82F63B78u & (0u - (_Crc & 1)));
+        _Table.entries[byte] = _Crc;
+    }
+    return _Table;
+}();
+
+_STD_API_END
+
+_STD_API_BEGIN
+
+/// <summary>
+/// 64 bit hash of a byte range (wyhash). Not cryptographic, but fast on every length and
+/// well distributed in all 64 bits, so tables can use any subset of them.
+/// Usable in constant expressions, the result is the same at compile time and run time.
+/// </summary>
+_NODISCARD _STD_API uint64 hash_string(std::string_view bytes, uint64 seed = 0) noexcept {
+    const auto& _Secret = _DETAIL _Wy_secret;
+    const char* _Ptr = bytes.data();
+    const size_t _Length = bytes.size();
+    seed ^= _DETAIL _Wy_mix(seed ^ _Secret[0], _Secret[1]);
+
+    uint64 _A, _B;
+    if (_Length <= 16) {
+        if (_Length >= 4) {
+            const size_t _Middle = (_Length >> 3) << 2;
+            _A = (_DETAIL _Wy_read4(_Ptr) << 32) | _DETAIL _Wy_read4(_Ptr + _Middle);
+            _B = (_DETAIL _Wy_read4(_Ptr + _Length - 4) << 32) | _DETAIL _Wy_read4(_Ptr + _Length - 4 - _Middle);
+        }
+        else if (_Length > 0) {
+            _A = _DETAIL _Wy_read3(_Ptr, _Length);
+            _B = 0;
+        }
+        else {
+            _A = _B = 0;
+        }
+    }
+    else {
+        size_t _Left = _Length;
+        if (_Left > 48) {
+            // three independent lanes keep the multipliers busy.
+            uint64 _Lane1 = seed, _Lane2 = seed;
+            do {
+                seed = _DETAIL _Wy_mix(_DETAIL _Wy_read8(_Ptr) ^ _Secret[1], _DETAIL _Wy_read8(_Ptr + 8) ^ seed);
+                _Lane1 = _DETAIL _Wy_mix(_DETAIL _Wy_read8(_Ptr + 16) ^ _Secret[2], _DETAIL _Wy_read8(_Ptr + 24) ^ _Lane1);
+                _Lane2 = _DETAIL _Wy_mix(_DETAIL _Wy_read8(_Ptr + 32) ^ _Secret[3], _DETAIL _Wy_read8(_Ptr + 40) ^ _Lane2);
+                _Ptr += 48;
+                _Left -= 48;
+            } while (_Left > 48);
+            seed ^= _Lane1 ^ _Lane2;
+        }
+        while (_Left > 16) {
+            seed = _DETAIL _Wy_mix(_DETAIL _Wy_read8(_Ptr) ^ _Secret[1], _DETAIL _Wy_read8(_Ptr + 8) ^ seed);
+            _Ptr += 16;
+            _Left -= 16;
+        }
+        _A = _DETAIL _Wy_read8(_Ptr + _Left - 16);
+        _B = _DETAIL _Wy_read8(_Ptr + _Left - 8);
+    }
+
+    _A ^= _Secret[1];
+    _B ^= seed;
+    _DETAIL _Wy_mum(_A, _B);
+    return _DETAIL _Wy_mix(_A ^ _Secret[0] ^ _Length, _B ^ _Secret[1]);
+}
+
+_NODISCARD _STD_INLINE uint64 hash_bytes(const void* data, size_t length, uint64 seed = 0) noexcept {
+    return hash_string(std::string_view(static_cast<const char*>(data), length), seed);
+}
+
+// One 128 bit multiply, every input bit affects every output bit.
+_NODISCARD _STD_API uint64 hash_u64(uint64 value, uint64 seed = 0) noexcept {
+    return _DETAIL _Wy_mix(value ^ seed ^ _DETAIL _Wy_secret[0], _DETAIL _Wy_secret[1]);
+}
+
+// Fold `value` into an existing hash, order dependent.
+_NODISCARD _STD_API uint64 hash_combine(uint64 seed, uint64 value) noexcept {
+    return _DETAIL _Wy_mix(seed ^ _DETAIL _Wy_secret[1], value ^ _DETAIL _Wy_secret[2]);
+}
+
+/// <summary>
+/// CRC32C of a byte range, continuing from `crc` (pass a previous result to checksum in pieces).
+/// Uses the SSE4.2 crc32 instruction, 8 bytes per instruction, when the build targets it.
+/// </summary>
+_NODISCARD _STD_INLINE uint32 crc32c(const void* data, size_t length, uint32 crc = 0) noexcept {
+    const auto* _Bytes = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+#if defined(_STD_HASH_CRC32C_HW)
+#if defined(_M_X64) || defined(__x86_64__)
+    uint64 _Wide = crc;
+    for (; length >= 8; length -= 8, _Bytes += 8) {
+        uint64 _Chunk;
+        std::memcpy(&_Chunk, _Bytes, sizeof(_Chunk));
+        _Wide = _mm_crc32_u64(_Wide, _Chunk);
+    }
+    crc = static_cast<uint32>(_Wide);
+#endif
+    for (; length >= 4; length -= 4, _Bytes += 4) {
+        uint32 _Chunk;
+        std::memcpy(&_Chunk, _Bytes, sizeof(_Chunk));
+        crc = _mm_crc32_u32(crc, _Chunk);
+    }
+    for (; length > 0; --length, ++_Bytes)
+        crc = _mm_crc32_u8(crc, *_Bytes);
+#else
+    for (; length > 0; --length, ++_Bytes)
+        crc = _DETAIL _Crc32c_table.entries[(crc ^ *_Bytes) & 0xFF] ^ (crc >> 8);
+#endif
+    return ~crc;
+}
+
+_STD_API_END
+
+_STD_DETAIL_API
+
+// string.hpp is not included here, it depends on os.hpp.
+template <class _CharT, class _Traits>
+class _Basic_string;
+
+template <class T>
+struct _Is_stud_string : std::false_type {};
+template <class _Traits>
+struct _Is_stud_string<_Basic_string<char, _Traits>> : std::true_type {};
+
+template <class T>
+concept _Hash_string_like = std::is_convertible_v<const T&, std::string_view>
+    || _Is_stud_string<std::remove_cvref_t<T>>::value;
+
+template <class T>
+_STD_API std::string_view _As_string_view(const T& value) noexcept {
+    if constexpr (_Is_stud_string<std::remove_cvref_t<T>>::value) {
+        // an empty stud::string has no buffer at all.
+        return value.data() ? std::string_view(value.data(), value.size()) : std::string_view();
+    }
+    else {
+        return std::string_view(value);
+    }
+}
+
+/// <summary>
+/// Whether a container keyed by K may hash and compare a probe of type Q as it is. Both
+/// functors have to be transparent, and both types string-like: only there does hashing
+/// the probe give the same value as hashing the K it converts to (an int probe hashes
+/// other bits than the double it stands for).
+/// </summary>
+template <class Hasher, class KeyEqual, class K, class Q>
+inline constexpr bool _Is_transparent_lookup = requires {
+    typename Hasher::is_transparent;
+    typename KeyEqual::is_transparent;
+} && _Hash_string_like<K> && _Hash_string_like<Q>;
+
+// What a probe is hashed and compared as: itself for a transparent lookup, otherwise the key type.
+template <class Hasher, class KeyEqual, class K, class Q>
+using _Lookup_key = std::conditional_t<_Is_transparent_lookup<Hasher, KeyEqual, K, Q>, Q, K>;
+
+_STD_API_END
+
+_STD_API_BEGIN
+
+/// <summary>
+/// The hash every stud container uses. Covers integers, enums, floats, pointers and strings
+/// (all string types hash alike, so they can be looked up with each other).
+/// Specialize it for your own types:
+///
+///     template <> struct stud::Hash<Point> {
+///         uint64 operator()(const Point& p) const noexcept { return hash_combine(hash_u64(p.x), p.y); }
+///     };
+///
+/// Anything else with a std::hash specialization falls back to that, remixed.
+/// </summary>
+template <class T>
+struct Hash {
+    _NODISCARD _STD_API uint64 operator()(const T& value) const noexcept {
+        if constexpr (_DETAIL _Hash_string_like<T>) {
+            return hash_string(_DETAIL _As_string_view(value));
+        }
+        else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+            return hash_u64(static_cast<uint64>(value));
+        }
+        else if constexpr (std::is_pointer_v<T>) {
+            return hash_u64(static_cast<uint64>(reinterpret_cast<uintptr>(value)));
+        }
+        else if constexpr (std::is_floating_point_v<T>) {
+            // +0.0 and -0.0 compare equal, they must hash equal.
+            if (value == T{ 0 })
+                return hash_u64(0);
+            if constexpr (sizeof(T) == sizeof(uint64))
+                return hash_u64(std::bit_cast<uint64>(value));
+            else if constexpr (sizeof(T) == sizeof(uint32))
+                return hash_u64(std::bit_cast<uint32>(value));
+            else
+                return hash_bytes(&value, sizeof(T));
+        }
+        else {
+            return hash_u64(static_cast<uint64>(std::hash<T>{}(value)));
+        }
+    }
+};
+
+/// <summary>
+/// Hash<T> for whatever type is passed in. Transparent for strings: containers using it
+/// look up a stud::string key with a string_view or a literal as is. Any other probe is
+/// converted to the key type first (see _Is_transparent_lookup).
+/// </summary>
+struct DefaultHasher {
+    using is_transparent = void;
+
+    template <class T>
+    _NODISCARD _STD_API uint64 operator()(const T& key) const noexcept {
+        if constexpr (_DETAIL _Hash_string_like<T>)
+            return hash_string(_DETAIL _As_string_view(key));
+        else
+            return Hash<T>{}(key);
+    }
+};
+
+// Transparent equality to go with DefaultHasher.
+struct DefaultKeyEqual {
+    using is_transparent = void;
+
+    template <class L, class R>
+    _NODISCARD _STD_API bool operator()(const L& left, const R& right) const noexcept {
+        if constexpr (_DETAIL _Hash_string_like<L> && _DETAIL _Hash_string_like<R>)
+            return _DETAIL _As_string_view(left) == _DETAIL _As_string_view(right);
+        else
+            return left == right;
+    }
+};
+
+_STD_API_END
+
+#define _STD_HASH
+#endif
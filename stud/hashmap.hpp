@@ -0,0 +1,511 @@
+
+#ifndef _STD_HASHMAP
+
+#include <bit>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define _STD_HASHMAP_SSE2 1
+#endif
+
+#include "forward.hpp"
+#include "stddef.hpp"
+#include "panic.hpp"
+#include "algorithm.hpp"
+#include "hash.hpp"
+
+_STD_DETAIL_API
+
+using _Ctrl = int8_t;
+
+// A full slot stores the low 7 bits of its hash, so every special value has the top bit set.
+inline constexpr _Ctrl _Ctrl_empty = -128;   // 0b10000000
+inline constexpr _Ctrl _Ctrl_deleted = -2;   // 0b11111110
+
+#if defined(_STD_HASHMAP_SSE2)
+// 16 control bytes compared at once, one bit per matching byte.
+struct _Ctrl_group {
+    static constexpr size_t Width = 16;
+    static constexpr size_t Shift = 0;
+
+    __m128i _Bytes;
+
+    inline explicit _Ctrl_group(const _Ctrl* ctrl) noexcept
+        : _Bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl)))
+    {}
+
+    _NODISCARD inline uint64 match(_Ctrl h2) const noexcept {
+        return static_cast<uint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), _Bytes)));
+    }
+    _NODISCARD inline uint64 match_empty() const noexcept {
+        return static_cast<uint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(_Ctrl_empty), _Bytes)));
+    }
+    // Empty and deleted are the only negative values below -1.
+    _NODISCARD inline uint64 match_empty_or_deleted() const noexcept {
+        return static_cast<uint32>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), _Bytes)));
+    }
+};
+#else
+// 8 control bytes in a word, the matching byte gets its top bit set.
+// match() can report false positives next to a real match, the key comparison filters them.
+struct _Ctrl_group {
+    static constexpr size_t Width = 8;
+    static constexpr size_t Shift = 3;
+    static constexpr uint64 _Lsbs = 0x0101010101010101ull;
+    static constexpr uint64 _Msbs = 0x8080808080808080ull;
+
+    uint64 _Bytes;
+
+    inline explicit _Ctrl_group(const _Ctrl* ctrl) noexcept {
+        std::memcpy(&_Bytes, ctrl, sizeof(_Bytes));
+    }
+
+    _NODISCARD inline uint64 match(_Ctrl h2) const noexcept {
+        const uint64 _Diff = _Bytes ^ (_Lsbs * static_cast<uint8_t>(h2));
+        return (_Diff - _Lsbs) & ~_Diff & _Msbs;
+    }
+    _NODISCARD inline uint64 match_empty() const noexcept {
+        return (_Bytes & (~_Bytes << 6)) & _Msbs;
+    }
+    _NODISCARD inline uint64 match_empty_or_deleted() const noexcept {
+        return (_Bytes & (~_Bytes << 7)) & _Msbs;
+    }
+};
+#endif
+
+_STD_API_END
+
+_STD_API_BEGIN
+
+/// <summary>
+/// An open addressing hash map in the style of SwissTable. Entries live in one flat array
+/// next to a byte of metadata per slot (empty, deleted, or 7 bits of the hash), and lookups
+/// compare a whole group of metadata bytes with one SIMD compare before touching any entry.
+///
+/// The hasher must produce well distributed 64 bit values (Hash<T> does), the low 7 bits are
+/// stored as the metadata and the rest picks the starting group. With transparent functors
+/// a string key can be looked up with any string-like type as is (a string_view for a
+/// stud::string), any other probe is converted to K first.
+///
+/// Pointers and references to entries are invalidated when the table grows.
+/// </summary>
+template <class K, class V, class Hasher = DefaultHasher, class KeyEqual = DefaultKeyEqual>
+class HashMap {
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = pair<K, V>;
+private:
+    using _Group = _DETAIL _Ctrl_group;
+    static constexpr size_t _Group_width = _Group::Width;
+
+    // string probes are looked up as is, anything else is converted to K first so it
+    // hashes the same as the key it stands for.
+    template <class Q>
+    using _Lookup_key = _DETAIL _Lookup_key<Hasher, KeyEqual, K, Q>;
+
+    value_type* _Slots{ nullptr };
+    _DETAIL _Ctrl* _Control{ nullptr };
+    size_t _Capacity{ 0 };
+    size_t _Size{ 0 };
+    size_t _Growth_left{ 0 };
+
+    [[no_unique_address]] Hasher _Hasher;
+    [[no_unique_address]] KeyEqual _Equal;
+
+    template <bool Const>
+    class _Iterator {
+    private:
+        friend class HashMap;
+        using _Map = std::conditional_t<Const, const HashMap, HashMap>;
+        _Map* _Owner{ nullptr };
+        size_t _Index{ 0 };
+
+        inline void _Skip_empty() noexcept {
+            while (_Index < _Owner->_Capacity && _Owner->_Control[_Index] < 0)
+                ++_Index;
+        }
+    public:
+        using value_type = HashMap::value_type;
+        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+        using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+        using difference_type = ptrdiff;
+
+        _Iterator() noexcept = default;
+        inline _Iterator(_Map* owner, size_t index) noexcept : _Owner(owner), _Index(index) {
+            _Skip_empty();
+        }
+        inline operator _Iterator<true>() const noexcept {
+            return _Iterator<true>(_Owner, _Index);
+        }
+
+        // The key must not be modified through the entry.
+        _NODISCARD inline reference operator*() const noexcept {
+            return _Owner->_Slots[_Index];
+        }
+        _NODISCARD inline pointer operator->() const noexcept {
+            return _Owner->_Slots + _Index;
+        }
+        inline _Iterator& operator++() noexcept {
+            ++_Index;
+            _Skip_empty();
+            return *this;
+        }
+        inline _Iterator operator++(int) noexcept {
+            auto _Copy = *this;
+            ++*this;
+            return _Copy;
+        }
+        _NODISCARD inline bool operator==(const _Iterator& other) const noexcept {
+            return _Index == other._Index;
+        }
+    };
+public:
+    using iterator = _Iterator<false>;
+    using const_iterator = _Iterator<true>;
+
+    HashMap() noexcept = default;
+    inline explicit HashMap(size_t capacity, Hasher hasher = Hasher{}, KeyEqual equal = KeyEqual{}) noexcept
+        : _Hasher(std::move(hasher)), _Equal(std::move(equal))
+    {
+        reserve(capacity);
+    }
+    inline HashMap(std::initializer_list<value_type> entries) noexcept {
+        reserve(entries.size());
+        for (const auto& entry : entries)
+            insert(entry.key, entry.value);
+    }
+
+    inline HashMap(const HashMap& other) noexcept
+        : _Hasher(other._Hasher), _Equal(other._Equal)
+    {
+        reserve(other._Size);
+        for (const auto& entry : other)
+            _Insert_unique(_Hasher(entry.key), entry.key, entry.value);
+    }
+    inline HashMap(HashMap&& other) noexcept
+        : _Slots(std::exchange(other._Slots, nullptr))
+        , _Control(std::exchange(other._Control, nullptr))
+        , _Capacity(std::exchange(other._Capacity, 0))
+        , _Size(std::exchange(other._Size, 0))
+        , _Growth_left(std::exchange(other._Growth_left, 0))
+        , _Hasher(std::move(other._Hasher))
+        , _Equal(std::move(other._Equal))
+    {}
+
+    inline HashMap& operator=(const HashMap& other) noexcept {
+        if (this != &other) {
+            HashMap _Copy(other);
+            swap(_Copy);
+        }
+        return *this;
+    }
+    inline HashMap& operator=(HashMap&& other) noexcept {
+        if (this != &other) {
+            HashMap _Taken(std::move(other));
+            swap(_Taken);
+        }
+        return *this;
+    }
+
+    inline ~HashMap() noexcept {
+        _Destroy_all();
+        _Release(_Slots, _Capacity);
+    }
+
+    inline void swap(HashMap& other) noexcept {
+        std::swap(_Slots, other._Slots);
+        std::swap(_Control, other._Control);
+        std::swap(_Capacity, other._Capacity);
+        std::swap(_Size, other._Size);
+        std::swap(_Growth_left, other._Growth_left);
+        std::swap(_Hasher, other._Hasher);
+        std::swap(_Equal, other._Equal);
+    }
+
+    _NODISCARD inline size_t size() const noexcept {
+        return _Size;
+    }
+    _NODISCARD inline bool empty() const noexcept {
+        return _Size == 0;
+    }
+    _NODISCARD inline size_t capacity() const noexcept {
+        return _Capacity;
+    }
+
+    // Make room for `count` entries without growing again.
+    inline void reserve(size_t count) noexcept {
+        if (count <= _Size + _Growth_left)
+            return;
+        _Rehash(_Capacity_for(count));
+    }
+
+    inline void clear() noexcept {
+        _Destroy_all();
+        if (_Capacity) {
+            std::memset(_Control, _DETAIL _Ctrl_empty, _Capacity + _Group_width);
+            _Growth_left = _Max_load(_Capacity);
+        }
+        _Size = 0;
+    }
+
+    _NODISCARD inline iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+    _NODISCARD inline iterator end() noexcept {
+        return iterator(this, _Capacity);
+    }
+    _NODISCARD inline const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+    _NODISCARD inline const_iterator end() const noexcept {
+        return const_iterator(this, _Capacity);
+    }
+
+    template <class Q>
+    _NODISCARD inline iterator find(const Q& key) noexcept {
+        return iterator(this, _Find(static_cast<const _Lookup_key<Q>&>(key)));
+    }
+    template <class Q>
+    _NODISCARD inline const_iterator find(const Q& key) const noexcept {
+        return const_iterator(this, _Find(static_cast<const _Lookup_key<Q>&>(key)));
+    }
+
+    template <class Q>
+    _NODISCARD inline bool contains(const Q& key) const noexcept {
+        return _Find(static_cast<const _Lookup_key<Q>&>(key)) != _Capacity;
+    }
+
+    // nullptr when the key is not present.
+    template <class Q>
+    _NODISCARD inline V* get(const Q& key) noexcept {
+        const size_t _Index = _Find(static_cast<const _Lookup_key<Q>&>(key));
+        return _Index == _Capacity ? nullptr : &_Slots[_Index].value;
+    }
+    template <class Q>
+    _NODISCARD inline const V* get(const Q& key) const noexcept {
+        const size_t _Index = _Find(static_cast<const _Lookup_key<Q>&>(key));
+        return _Index == _Capacity ? nullptr : &_Slots[_Index].value;
+    }
+
+    template <class Q>
+    _NODISCARD inline V& at(const Q& key) noexcept {
+        auto* _Value = get(key);
+        panic(IF(_Value == nullptr), "HashMap::at(): key is not present.");
+        return *_Value;
+    }
+    template <class Q>
+    _NODISCARD inline const V& at(const Q& key) const noexcept {
+        const auto* _Value = get(key);
+        panic(IF(_Value == nullptr), "HashMap::at(): key is not present.");
+        return *_Value;
+    }
+
+    /// <summary>
+    /// Construct the value from `args` if `key` is not present yet.
+    /// Returns the entry, and whether it was inserted.
+    /// </summary>
+    template <class... Args>
+    inline std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) noexcept {
+        return _Try_emplace(K(key), std::forward<Args>(args)...);
+    }
+    template <class... Args>
+    inline std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) noexcept {
+        return _Try_emplace(std::move(key), std::forward<Args>(args)...);
+    }
+
+    // Returns false (and leaves the map alone) when the key already exists.
+    inline bool insert(K key, V value) noexcept {
+        return _Try_emplace(std::move(key), std::move(value)).second;
+    }
+
+    inline bool insert_or_assign(K key, V value) noexcept {
+        auto [_Where, _Inserted] = _Try_emplace(std::move(key), std::move(value));
+        if (!_Inserted) {
+            // _Try_emplace did not consume the value.
+            _Where->value = std::move(value);
+        }
+        return _Inserted;
+    }
+
+    inline V& operator[](const K& key) noexcept {
+        return _Try_emplace(K(key)).first->value;
+    }
+    inline V& operator[](K&& key) noexcept {
+        return _Try_emplace(std::move(key)).first->value;
+    }
+
+    template <class Q>
+    inline bool erase(const Q& key) noexcept {
+        const size_t _Index = _Find(static_cast<const _Lookup_key<Q>&>(key));
+        if (_Index == _Capacity)
+            return false;
+        _Erase_at(_Index);
+        return true;
+    }
+    inline iterator erase(const_iterator where) noexcept {
+        _Erase_at(where._Index);
+        return iterator(this, where._Index + 1);
+    }
+    inline iterator erase(iterator where) noexcept {
+        return erase(const_iterator(where));
+    }
+
+    _NODISCARD inline float64 load_factor() const noexcept {
+        return _Capacity ? static_cast<float64>(_Size) / static_cast<float64>(_Capacity) : 0.0;
+    }
+
+private:
+    // Tables fill to 7/8 before growing.
+    _NODISCARD static constexpr size_t _Max_load(size_t capacity) noexcept {
+        return capacity - capacity / 8;
+    }
+    _NODISCARD static constexpr size_t _Capacity_for(size_t count) noexcept {
+        size_t _Result = _Group_width;
+        while (_Max_load(_Result) < count)
+            _Result <<= 1;
+        return _Result;
+    }
+
+    _NODISCARD static constexpr _DETAIL _Ctrl _H2(uint64 hash) noexcept {
+        return static_cast<_DETAIL _Ctrl>(hash & 0x7F);
+    }
+    _NODISCARD static constexpr uint64 _H1(uint64 hash) noexcept {
+        return hash >> 7;
+    }
+
+    // Slots and control bytes share one allocation: [slots][control][mirror of the first group].
+    _NODISCARD static constexpr size_t _Control_offset(size_t capacity) noexcept {
+        return capacity * sizeof(value_type);
+    }
+    _NODISCARD static constexpr std::align_val_t _Alignment() noexcept {
+        return std::align_val_t{ alignof(value_type) > 16 ? alignof(value_type) : 16 };
+    }
+    static inline void _Release(value_type* slots, size_t capacity) noexcept {
+        if (slots)
+            ::operator delete(static_cast<void*>(slots), _Control_offset(capacity) + capacity + _Group_width, _Alignment());
+    }
+
+    inline void _Set_control(size_t index, _DETAIL _Ctrl value) noexcept {
+        _Control[index] = value;
+        // groups are loaded unaligned and may run past the end, those bytes mirror the start.
+        if (index < _Group_width)
+            _Control[_Capacity + index] = value;
+    }
+
+    inline void _Destroy_all() noexcept {
+        if constexpr (!std::is_trivially_destructible_v<value_type>) {
+            for (size_t index = 0; index < _Capacity; ++index) {
+                if (_Control[index] >= 0)
+                    _Slots[index].~value_type();
+            }
+        }
+    }
+
+    template <class Q>
+    _NODISCARD inline size_t _Find(const Q& key) const noexcept {
+        if (_Size == 0)
+            return _Capacity;
+        const uint64 _Hash = _Hasher(key);
+        const auto _Tag = _H2(_Hash);
+        const size_t _Mask = _Capacity - 1;
+
+        size_t _Position = static_cast<size_t>(_H1(_Hash)) & _Mask;
+        // triangular probing over groups, visits every group once when the capacity is a power of two.
+        for (size_t _Step = 1;; ++_Step) {
+            const _Group _Group_here(_Control + _Position);
+            for (uint64 _Matches = _Group_here.match(_Tag); _Matches; _Matches &= _Matches - 1) {
+                const size_t _Index = (_Position + (std::countr_zero(_Matches) >> _Group::Shift)) & _Mask;
+                if (_Equal(_Slots[_Index].key, key)) [[likely]]
+                    return _Index;
+            }
+            if (_Group_here.match_empty())
+                return _Capacity;
+            if (_Step * _Group_width >= _Capacity)
+                return _Capacity;
+            _Position = (_Position + _Step * _Group_width) & _Mask;
+        }
+    }
+
+    // First empty or deleted slot on the probe sequence of `hash`.
+    _NODISCARD inline size_t _Find_free(uint64 hash) const noexcept {
+        const size_t _Mask = _Capacity - 1;
+        size_t _Position = static_cast<size_t>(_H1(hash)) & _Mask;
+        for (size_t _Step = 1;; ++_Step) {
+            const uint64 _Free = _Group(_Control + _Position).match_empty_or_deleted();
+            if (_Free)
+                return (_Position + (std::countr_zero(_Free) >> _Group::Shift)) & _Mask;
+            _Position = (_Position + _Step * _Group_width) & _Mask;
+        }
+    }
+
+    // Place an entry known not to be in the table.
+    template <class Key, class... Args>
+    inline size_t _Insert_unique(uint64 hash, Key&& key, Args&&... args) noexcept {
+        if (_Capacity == 0)
+            _Rehash(_Group_width);
+        size_t _Index = _Find_free(hash);
+        if (_Growth_left == 0 && _Control[_Index] != _DETAIL _Ctrl_deleted) {
+            // reclaim tombstones when they are most of the load, otherwise double.
+            _Rehash(_Size * 2 < _Max_load(_Capacity) ? _Capacity : _Capacity_for(_Size + 1));
+            _Index = _Find_free(hash);
+        }
+        if (_Control[_Index] == _DETAIL _Ctrl_empty)
+            --_Growth_left;
+        ::new (static_cast<void*>(_Slots + _Index)) value_type{ K(std::forward<Key>(key)), V(std::forward<Args>(args)...) };
+        _Set_control(_Index, _H2(hash));
+        ++_Size;
+        return _Index;
+    }
+
+    template <class... Args>
+    inline std::pair<iterator, bool> _Try_emplace(K&& key, Args&&... args) noexcept {
+        const size_t _Existing = _Find(key);
+        if (_Existing != _Capacity)
+            return { iterator(this, _Existing), false };
+        const size_t _Index = _Insert_unique(_Hasher(key), std::move(key), std::forward<Args>(args)...);
+        return { iterator(this, _Index), true };
+    }
+
+    inline void _Erase_at(size_t index) noexcept {
+        _Slots[index].~value_type();
+        // a tombstone keeps probe chains running through this slot intact.
+        _Set_control(index, _DETAIL _Ctrl_deleted);
+        --_Size;
+    }
+
+    inline void _Rehash(size_t new_capacity) noexcept {
+        auto* _Old_slots = _Slots;
+        auto* _Old_control = _Control;
+        const size_t _Old_capacity = _Capacity;
+
+        void* _Memory = ::operator new(_Control_offset(new_capacity) + new_capacity + _Group_width, _Alignment());
+        _Slots = static_cast<value_type*>(_Memory);
+        _Control = reinterpret_cast<_DETAIL _Ctrl*>(static_cast<char*>(_Memory) + _Control_offset(new_capacity));
+        std::memset(_Control, _DETAIL _Ctrl_empty, new_capacity + _Group_width);
+        _Capacity = new_capacity;
+        _Growth_left = _Max_load(new_capacity) - _Size;
+
+        for (size_t index = 0; index < _Old_capacity; ++index) {
+            if (_Old_control[index] < 0)
+                continue;
+            auto& _Entry = _Old_slots[index];
+            const uint64 _Hash = _Hasher(_Entry.key);
+            const size_t _Target = _Find_free(_Hash);
+            ::new (static_cast<void*>(_Slots + _Target)) value_type{ std::move(_Entry.key), std::move(_Entry.value) };
+            _Set_control(_Target, _H2(_Hash));
+            _Entry.~value_type();
+        }
+        _Release(_Old_slots, _Old_capacity);
+    }
+};
+
+_STD_API_END
+
+#define _STD_HASHMAP
+#endif
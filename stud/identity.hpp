@@ -5,6 +5,7 @@
 #include <string>
 
 #include "forward.hpp"
+#include "hash.hpp"
 
 _STD_API_BEGIN
 
@@ -28,13 +29,8 @@ public:
     _STD_API Identity(const B& instance) noexcept {
         m_data.address = reinterpret_cast<size_t>(&instance);
         
-        auto* const name = typeid(B).name();
-        const auto length = std::char_traits<char>::length(name);
-        char* right = reinterpret_cast<char*>(&m_data.identifiers);
-
-        for (int i = 0; i < ((length > 8) ? 7 : length); ++i) {
-            right[i] = name[i];
-        }
+        // the whole type name, not just its first few characters.
+        m_data.identifiers = static_cast<size_t>(hash_string(typeid(B).name()));
 
         m_inst = &instance;
     }
@@ -1,6 +1,12 @@
 #pragma once
 
+#include <bit>
+#include <compare>
+#include <iterator>
+#include <type_traits>
+
 #include "forward.hpp"
+#include "stddef.hpp"
 
 _STD_API_BEGIN
 
@@ -14,4 +20,65 @@ class reverse_iterator {
 	//static_assert(false, "stud::reverse_iterator<T> must be specialized.");
 };
 
-_STD_API_END
\ No newline at end of file
+_STD_API_END
+
+_STD_DETAIL_API
+
+// Elements per segment for Deque and ChunkedVector: at least 16, otherwise about 4 KiB.
+// Always a power of two, so an index splits into segment and slot with a shift and a mask.
+template <class T>
+inline constexpr size_t _Segment_size = std::bit_floor(sizeof(T) * 16 > 4096 ? size_t{ 16 } : 4096 / sizeof(T));
+
+/// <summary>
+/// Random access iterator for containers that are indexed but not contiguous: it holds the
+/// container and a logical index and goes through operator[] on every access.
+/// </summary>
+template <class Owner, class T>
+class _Index_iterator {
+private:
+	Owner* _Owner{ nullptr };
+	size_t _Index{ 0 };
+public:
+	using iterator_category = std::random_access_iterator_tag;
+	using value_type = std::remove_const_t<T>;
+	using difference_type = ptrdiff;
+	using pointer = T*;
+	using reference = T&;
+
+	_Index_iterator() noexcept = default;
+	_STD_API _Index_iterator(Owner* owner, size_t index) noexcept
+		: _Owner(owner), _Index(index)
+	{}
+
+	_NODISCARD _STD_API reference operator*() const noexcept {
+		return (*_Owner)[_Index];
+	}
+	_NODISCARD _STD_API pointer operator->() const noexcept {
+		return &(*_Owner)[_Index];
+	}
+	_NODISCARD _STD_API reference operator[](difference_type offset) const noexcept {
+		return (*_Owner)[_Index + offset];
+	}
+
+	_STD_API _Index_iterator& operator++() noexcept { ++_Index; return *this; }
+	_STD_API _Index_iterator& operator--() noexcept { --_Index; return *this; }
+	_STD_API _Index_iterator operator++(int) noexcept { auto _Old = *this; ++_Index; return _Old; }
+	_STD_API _Index_iterator operator--(int) noexcept { auto _Old = *this; --_Index; return _Old; }
+	_STD_API _Index_iterator& operator+=(difference_type offset) noexcept { _Index += offset; return *this; }
+	_STD_API _Index_iterator& operator-=(difference_type offset) noexcept { _Index -= offset; return *this; }
+
+	_NODISCARD friend _STD_API _Index_iterator operator+(_Index_iterator it, difference_type offset) noexcept { return it += offset; }
+	_NODISCARD friend _STD_API _Index_iterator operator+(difference_type offset, _Index_iterator it) noexcept { return it += offset; }
+	_NODISCARD friend _STD_API _Index_iterator operator-(_Index_iterator it, difference_type offset) noexcept { return it -= offset; }
+	_NODISCARD friend _STD_API difference_type operator-(const _Index_iterator& left, const _Index_iterator& right) noexcept {
+		return static_cast<difference_type>(left._Index) - static_cast<difference_type>(right._Index);
+	}
+	_NODISCARD friend _STD_API bool operator==(const _Index_iterator& left, const _Index_iterator& right) noexcept {
+		return left._Index == right._Index;
+	}
+	_NODISCARD friend _STD_API auto operator<=>(const _Index_iterator& left, const _Index_iterator& right) noexcept {
+		return left._Index <=> right._Index;
+	}
+};
+
+_STD_API_END
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "forward.hpp"
+#include "time.hpp"
 
 #include <iostream>
 #include <string>
@@ -99,4 +100,16 @@ _STD_INLINE default_logger make_logger() {
 	return logger;
 }
 
+// Same as make_logger(), with each line prefixed by the CoarseClock timestamp.
+_STD_INLINE default_logger make_timestamped_logger() {
+	auto logger = default_logger{};
+	logger.with_log_fmt([](LogLevel level, const std::string& message) {
+		char stamp[CoarseClock::TimestampLength];
+		CoarseClock::global().timestamp(stamp);
+		auto postfix_msg = log_level_to_string(level);
+		return std::format("{} [{}] {}", std::string_view(stamp, sizeof(stamp)), postfix_msg, message);
+	});
+	return logger;
+}
+
 _STD_API_END
\ No newline at end of file
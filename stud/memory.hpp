@@ -1,6 +1,9 @@
 
 #ifndef _STD_MEMORY
 
+#include <atomic>
+#include <concepts>
+#include <type_traits>
 #include <utility>
 #include <dbghelp.h>
 #include <Windows.h>
@@ -72,6 +75,152 @@ public:
     }
 };
 
+// The reference count behind Rc and non-atomic RefCounted.
+class _Local_count {
+private:
+    size_t _Count;
+public:
+    _STD_API explicit _Local_count(size_t initial) noexcept
+        : _Count(initial)
+    {}
+
+    _STD_API void _Increment() noexcept {
+        ++_Count;
+    }
+    // true when that was the last reference.
+    _NODISCARD _STD_API bool _Decrement() noexcept {
+        return --_Count == 0;
+    }
+    _NODISCARD _STD_API size_t _Load() const noexcept {
+        return _Count;
+    }
+};
+
+// The reference count behind Arc and RefCounted<true>. Increments are relaxed, a new
+// reference is only made from an existing one. The final decrement synchronizes with
+// every earlier one so the destructor sees all writes made through other references.
+class _Atomic_count {
+private:
+    std::atomic<size_t> _Count;
+public:
+    inline explicit _Atomic_count(size_t initial) noexcept
+        : _Count(initial)
+    {}
+
+    inline void _Increment() noexcept {
+        _Count.fetch_add(1, std::memory_order_relaxed);
+    }
+    _NODISCARD inline bool _Decrement() noexcept {
+        if (_Count.fetch_sub(1, std::memory_order_release) != 1)
+            return false;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+    }
+    _NODISCARD inline size_t _Load() const noexcept {
+        return _Count.load(std::memory_order_relaxed);
+    }
+};
+
+// The count and the object in a single allocation, the count first so a
+// reference change touches the same cache line the object starts on.
+template <class T, class Count>
+struct _Counted_block {
+    Count _Count;
+    T _Value;
+
+    template <typename... Ts>
+    inline explicit _Counted_block(Ts&&... args) noexcept
+        : _Count(1), _Value(std::forward<Ts>(args)...)
+    {}
+};
+
+/// <summary>
+/// The shared owner behind Rc and Arc, one pointer to a _Counted_block. Const is
+/// shallow, as with std::shared_ptr: a const Rc&lt;T&gt; still hands out T*.
+/// </summary>
+template <class T, class Count>
+class _Counted_ptr {
+private:
+    using _Block = _Counted_block<T, Count>;
+
+    _Block* _Ptr{ nullptr };
+
+    inline explicit _Counted_ptr(_Block* block) noexcept
+        : _Ptr(block)
+    {}
+
+    template <class U, class C, typename... Ts>
+    friend _Counted_ptr<U, C> _Make_counted(Ts&&... args) noexcept;
+public:
+    _Counted_ptr() noexcept = default;
+    inline _Counted_ptr(const _Counted_ptr& other) noexcept
+        : _Ptr(other._Ptr)
+    {
+        if (_Ptr)
+            _Ptr->_Count._Increment();
+    }
+    inline _Counted_ptr(_Counted_ptr&& other) noexcept
+        : _Ptr(std::exchange(other._Ptr, nullptr))
+    {}
+    inline _Counted_ptr& operator=(const _Counted_ptr& other) noexcept {
+        _Counted_ptr(other).swap(*this);
+        return *this;
+    }
+    inline _Counted_ptr& operator=(_Counted_ptr&& other) noexcept {
+        _Counted_ptr(std::move(other)).swap(*this);
+        return *this;
+    }
+    inline ~_Counted_ptr() noexcept {
+        reset();
+    }
+
+    // Drops this reference, destroying the object if it was the last.
+    inline void reset() noexcept {
+        if (_Ptr && _Ptr->_Count._Decrement())
+            delete _Ptr;
+        _Ptr = nullptr;
+    }
+
+    _NODISCARD inline T* get() const noexcept {
+        return _Ptr ? &_Ptr->_Value : nullptr;
+    }
+    _NODISCARD inline T& operator*() const noexcept {
+        panic(IF_NOT(_Ptr), "cannot dereference a null reference counted pointer.");
+        return _Ptr->_Value;
+    }
+    _NODISCARD inline T* operator->() const noexcept {
+        return &**this;
+    }
+
+    _NODISCARD inline bool is_null() const noexcept {
+        return _Ptr == nullptr;
+    }
+    // 0 for a null pointer. Only a snapshot for Arc, other threads may change it.
+    _NODISCARD inline size_t use_count() const noexcept {
+        return _Ptr ? _Ptr->_Count._Load() : 0;
+    }
+    _NODISCARD inline bool is_unique() const noexcept {
+        return use_count() == 1;
+    }
+
+    inline void swap(_Counted_ptr& other) noexcept {
+        std::swap(_Ptr, other._Ptr);
+    }
+    friend inline void swap(_Counted_ptr& left, _Counted_ptr& right) noexcept {
+        left.swap(right);
+    }
+
+    // Identity, not value: true when both share the same object.
+    _NODISCARD friend inline bool operator==(const _Counted_ptr& left, const _Counted_ptr& right) noexcept {
+        return left._Ptr == right._Ptr;
+    }
+};
+
+template <class T, class Count, typename... Ts>
+_NODISCARD _Counted_ptr<T, Count> _Make_counted(Ts&&... args) noexcept {
+    return _Counted_ptr<T, Count>(new _Counted_block<T, Count>(std::forward<Ts>(args)...));
+}
+
 _STD_API_END
 
 _STD_API_BEGIN
@@ -153,6 +302,144 @@ _STD_API UniquePtr<T> make_unique(Ts&&... args) noexcept {
     return UniquePtr<T>(std::forward<Ts>(args)...);
 }
 
+/// <summary>
+/// Shared ownership for a single thread. The count lives in the same allocation as the
+/// object (see make_rc), so there is no separate control block and the count is a plain
+/// integer. Use Arc when references cross threads.
+/// </summary>
+template <class T>
+using Rc = _DETAIL _Counted_ptr<T, _DETAIL _Local_count>;
+
+/// <summary>
+/// Rc with an atomic count, safe to copy and drop from any number of threads. The object
+/// itself is not synchronized.
+/// </summary>
+template <class T>
+using Arc = _DETAIL _Counted_ptr<T, _DETAIL _Atomic_count>;
+
+template <class T, typename ...Ts>
+_NODISCARD _STD_INLINE Rc<T> make_rc(Ts&&... args) noexcept {
+    return _DETAIL _Make_counted<T, _DETAIL _Local_count>(std::forward<Ts>(args)...);
+}
+
+template <class T, typename ...Ts>
+_NODISCARD _STD_INLINE Arc<T> make_arc(Ts&&... args) noexcept {
+    return _DETAIL _Make_counted<T, _DETAIL _Atomic_count>(std::forward<Ts>(args)...);
+}
+
+/// <summary>
+/// A type that carries its own reference count: add_ref() takes a reference and
+/// release_ref() drops one, returning true when it was the last.
+/// </summary>
+template <class T>
+concept IntrusivelyCounted = requires(T& value) {
+    value.add_ref();
+    { value.release_ref() } -> std::same_as<bool>;
+};
+
+/// <summary>
+/// The count for an intrusively counted type, inherit from it:
+///
+///     struct Node : stud::RefCounted&lt;true&gt; { ... };
+///     stud::IntrusivePtr&lt;Node&gt; node(new Node());
+///
+/// Atomic selects a count that is safe across threads. Copying the object does not
+/// copy its references, the copy starts unowned.
+/// </summary>
+template <bool Atomic = false>
+class RefCounted {
+private:
+    using _Count_type = std::conditional_t<Atomic, _DETAIL _Atomic_count, _DETAIL _Local_count>;
+
+    mutable _Count_type _Count{ 0 };
+public:
+    RefCounted() noexcept = default;
+    inline RefCounted(const RefCounted&) noexcept {}
+    inline RefCounted& operator=(const RefCounted&) noexcept {
+        return *this;
+    }
+
+    inline void add_ref() const noexcept {
+        _Count._Increment();
+    }
+    _NODISCARD inline bool release_ref() const noexcept {
+        return _Count._Decrement();
+    }
+    _NODISCARD inline size_t ref_count() const noexcept {
+        return _Count._Load();
+    }
+protected:
+    ~RefCounted() noexcept = default;
+};
+
+/// <summary>
+/// A shared pointer to a type that counts its own references, so it is one raw pointer
+/// wide and never allocates. Adopting a raw pointer takes a reference, which means the
+/// same object can be handed to IntrusivePtr again from a plain T* (this, for example).
+/// The last release deletes the object.
+/// </summary>
+template <IntrusivelyCounted T>
+class IntrusivePtr {
+private:
+    T* _Ptr{ nullptr };
+public:
+    IntrusivePtr() noexcept = default;
+    inline explicit IntrusivePtr(T* ptr) noexcept
+        : _Ptr(ptr)
+    {
+        if (_Ptr)
+            _Ptr->add_ref();
+    }
+    inline IntrusivePtr(const IntrusivePtr& other) noexcept
+        : IntrusivePtr(other._Ptr)
+    {}
+    inline IntrusivePtr(IntrusivePtr&& other) noexcept
+        : _Ptr(std::exchange(other._Ptr, nullptr))
+    {}
+    inline IntrusivePtr& operator=(const IntrusivePtr& other) noexcept {
+        IntrusivePtr(other).swap(*this);
+        return *this;
+    }
+    inline IntrusivePtr& operator=(IntrusivePtr&& other) noexcept {
+        IntrusivePtr(std::move(other)).swap(*this);
+        return *this;
+    }
+    inline ~IntrusivePtr() noexcept {
+        reset();
+    }
+
+    inline void reset() noexcept {
+        if (_Ptr && _Ptr->release_ref())
+            delete _Ptr;
+        _Ptr = nullptr;
+    }
+
+    _NODISCARD inline T* get() const noexcept {
+        return _Ptr;
+    }
+    _NODISCARD inline T& operator*() const noexcept {
+        panic(IF_NOT(_Ptr), "cannot dereference a null IntrusivePtr.");
+        return *_Ptr;
+    }
+    _NODISCARD inline T* operator->() const noexcept {
+        return &**this;
+    }
+    _NODISCARD inline bool is_null() const noexcept {
+        return _Ptr == nullptr;
+    }
+
+    inline void swap(IntrusivePtr& other) noexcept {
+        std::swap(_Ptr, other._Ptr);
+    }
+    friend inline void swap(IntrusivePtr& left, IntrusivePtr& right) noexcept {
+        left.swap(right);
+    }
+
+    _NODISCARD friend inline bool operator==(const IntrusivePtr& left, const IntrusivePtr& right) noexcept {
+        return left._Ptr == right._Ptr;
+    }
+};
+
 _STD_INLINE void memcpy(void* dst, const void* src, size_t len) noexcept {
     char* _Dst = reinterpret_cast<char*>(dst);
     const char* _Src = reinterpret_cast<const char*>(src);
@@ -1,9 +1,11 @@
 #ifndef _STD_OPTION
 
+#include <algorithm>
 #include <variant>
 #include <utility>
 
 #include "forward.hpp"
+#include "format.hpp"
 
 _STD_API_BEGIN
 
@@ -34,6 +36,11 @@ public:
         return *std::get_if<0>(&_Variant);
     }
 
+    // The value without copying it, only valid when is_some().
+    _NODISCARD _STD_API const _Ty& view() const noexcept {
+        return *std::get_if<0>(&_Variant);
+    }
+
     _NODISCARD _STD_API _Ty unwrap_or(_Ty other) const noexcept {
         if (is_none()) {
             return other;
@@ -54,5 +61,23 @@ _NODISCARD auto Some(auto value) -> Option<decltype(value)> {
 
 _STD_API_END
 
+namespace std {
+
+// "Some(value)" or "None", the format spec applies to the value.
+template <class T>
+    requires stud::__detail::_Formattable_element<T>
+struct formatter<stud::Option<T>, char> : stud::__detail::_Wrapper_formatter<T> {
+    template <class FormatContext>
+    auto format(const stud::Option<T>& option, FormatContext& ctx) const {
+        if (option.is_none()) {
+            constexpr std::string_view _None = "None";
+            return std::copy(_None.begin(), _None.end(), ctx.out());
+        }
+        return this->_Format("Some", option.view(), ctx);
+    }
+};
+
+} // namespace std
+
 #define _STD_OPTION
 #endif
\ No newline at end of file
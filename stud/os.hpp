@@ -7,6 +7,7 @@
 #include "forward.hpp"
 
 #include "result.hpp"
+#include "static_map.hpp"
 
 #ifdef _WIN32
     #include <windows.h>
@@ -14,6 +15,7 @@
 
 #include "_os_file_info.hpp"
 #include "_os_environment.hpp"
+#include "_os_file_watcher.hpp"
 
 _STD_API_BEGIN
 
@@ -56,7 +58,7 @@ _STD_API
 bool 
 likely_windows_file(std::string_view fileNameOrPath)
 {
-    constexpr auto _Array_items = stud::make_array<std::string_view>(".exe", ".sys", ".dll");
+    constexpr auto _Windows_extensions = stud::make_static_set<std::string_view>({ ".exe", ".sys", ".dll" });
 
     auto& path = fileNameOrPath;
     auto dot_position = path.find('.');
@@ -65,7 +67,7 @@ likely_windows_file(std::string_view fileNameOrPath)
         return false;
 
     auto extension = path.substr(dot_position, path.size() - dot_position + 1);
-    return _Array_items.contains(extension);
+    return _Windows_extensions.contains(extension);
 }
 
 _STD_API
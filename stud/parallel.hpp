@@ -0,0 +1,374 @@
+
+#ifndef _STD_PARALLEL
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "forward.hpp"
+#include "stddef.hpp"
+#include "panic.hpp"
+
+_STD_API_BEGIN
+
+/// <summary>
+/// A fixed set of worker threads pulling from one queue. The process wide pool (global())
+/// has one thread less than the machine has cores, the thread that starts parallel work
+/// always takes part in it.
+/// </summary>
+class ThreadPool {
+private:
+    std::vector<std::thread> _Workers;
+    std::deque<std::function<void()>> _Queue;
+    std::mutex _Mutex;
+    std::condition_variable _Wake;
+    bool _Stopping{ false };
+
+    inline void _Run() noexcept {
+        for (;;) {
+            std::function<void()> _Task;
+            {
+                std::unique_lock _Lock(_Mutex);
+                _Wake.wait(_Lock, [this] { return _Stopping || !_Queue.empty(); });
+                if (_Queue.empty())
+                    return;
+                _Task = std::move(_Queue.front());
+                _Queue.pop_front();
+            }
+            _Task();
+        }
+    }
+public:
+    _STD_MAKE_NONCOPYABLE(ThreadPool);
+    _STD_MAKE_NONMOVEABLE(ThreadPool);
+
+    inline explicit ThreadPool(size_t threads) noexcept {
+        _Workers.reserve(threads);
+        for (size_t i = 0; i < threads; ++i)
+            _Workers.emplace_back([this] { _Run(); });
+    }
+
+    // Finishes every queued task before joining.
+    inline ~ThreadPool() noexcept {
+        {
+            std::lock_guard _Lock(_Mutex);
+            _Stopping = true;
+        }
+        _Wake.notify_all();
+        for (auto& worker : _Workers)
+            worker.join();
+    }
+
+    inline void submit(std::function<void()> task) noexcept {
+        {
+            std::lock_guard _Lock(_Mutex);
+            _Queue.push_back(std::move(task));
+        }
+        _Wake.notify_one();
+    }
+
+    _NODISCARD inline size_t thread_count() const noexcept {
+        return _Workers.size();
+    }
+
+    _NODISCARD static inline ThreadPool& global() noexcept {
+        static ThreadPool _Pool([] {
+            const size_t _Cores = std::thread::hardware_concurrency();
+            return _Cores > 1 ? _Cores - 1 : 1;
+        }());
+        return _Pool;
+    }
+};
+
+_STD_API_END
+
+_STD_DETAIL_API
+
+// Work shared between the caller and the helpers it woke, helpers may outlive the call.
+struct _Parallel_job {
+    std::atomic<size_t> next{ 0 };
+    std::atomic<size_t> done{ 0 };
+    size_t chunks{ 0 };
+    std::mutex mutex;
+    std::condition_variable finished;
+};
+
+/// <summary>
+/// Calls fn(chunk_index) for every chunk in [0, chunks). Threads claim chunks from a shared
+/// counter, so uneven chunks balance themselves. The caller works too and returns once every
+/// chunk has run, which also makes nested parallel calls from inside a chunk safe.
+/// </summary>
+template <class Fn>
+_STD_INLINE void _Parallel_chunks(size_t chunks, Fn&& fn, ThreadPool& pool = ThreadPool::global()) noexcept {
+    if (chunks == 0)
+        return;
+    if (chunks == 1 || pool.thread_count() == 0) {
+        for (size_t index = 0; index < chunks; ++index)
+            fn(index);
+        return;
+    }
+
+    auto _Job = std::make_shared<_Parallel_job>();
+    _Job->chunks = chunks;
+    auto* _Fn = std::addressof(fn);
+
+    // fn lives on our stack, helpers may only call it while chunks are left to claim,
+    // and we do not return before every claimed chunk is done.
+    auto _Work = [_Job, _Fn]() {
+        for (;;) {
+            const size_t _Index = _Job->next.fetch_add(1, std::memory_order_relaxed);
+            if (_Index >= _Job->chunks)
+                return;
+            (*_Fn)(_Index);
+            if (_Job->done.fetch_add(1, std::memory_order_acq_rel) + 1 == _Job->chunks) {
+                std::lock_guard _Lock(_Job->mutex);
+                _Job->finished.notify_all();
+            }
+        }
+    };
+
+    const size_t _Helpers = std::min(pool.thread_count(), chunks - 1);
+    for (size_t i = 0; i < _Helpers; ++i)
+        pool.submit(_Work);
+    _Work();
+
+    std::unique_lock _Lock(_Job->mutex);
+    _Job->finished.wait(_Lock, [&] { return _Job->done.load(std::memory_order_acquire) == _Job->chunks; });
+}
+
+// Elements per chunk when the caller does not choose: about 8 chunks per thread, never tiny.
+_STD_INLINE size_t _Default_grain(size_t count, ThreadPool& pool) noexcept {
+    const size_t _Threads = pool.thread_count() + 1;
+    const size_t _Grain = count / (_Threads * 8);
+    return _Grain < 2048 ? 2048 : _Grain;
+}
+
+// Splits [0, count) into ranges of `grain` elements, fn(begin, end) per range.
+template <class Fn>
+_STD_INLINE void _Parallel_ranges(size_t count, size_t grain, Fn&& fn, ThreadPool& pool = ThreadPool::global()) noexcept {
+    if (grain == 0)
+        grain = _Default_grain(count, pool);
+    const size_t _Chunks = (count + grain - 1) / grain;
+    _Parallel_chunks(_Chunks, [&](size_t chunk) {
+        const size_t _Begin = chunk * grain;
+        fn(_Begin, std::min(_Begin + grain, count));
+    }, pool);
+}
+
+/// <summary>
+/// Merge path: the split point of merging a and b so that the first `diagonal` outputs
+/// take i elements from a and diagonal - i from b. Lets one merge be cut into independent pieces.
+/// </summary>
+template <class T, class Compare>
+_STD_INLINE size_t _Merge_path(const T* a, size_t a_size, const T* b, size_t b_size, size_t diagonal, Compare& compare) noexcept {
+    size_t _Low = diagonal > b_size ? diagonal - b_size : 0;
+    size_t _High = std::min(diagonal, a_size);
+    while (_Low < _High) {
+        const size_t _Mid = _Low + (_High - _Low) / 2;
+        // take from a while a[mid] <= b[diagonal - mid - 1], ties go to a.
+        if (!compare(b[diagonal - _Mid - 1], a[_Mid]))
+            _Low = _Mid + 1;
+        else
+            _High = _Mid;
+    }
+    return _Low;
+}
+
+_STD_API_END
+
+_STD_API_BEGIN
+
+/*
+    Parallel algorithms on contiguous containers (Vector, Array, std::vector, ...), run on
+    ThreadPool::global(). `grain` is the number of elements each task handles, 0 picks one.
+    Small inputs run on the calling thread. The callables must be safe to call concurrently.
+*/
+namespace par {
+
+// Pass as `grain` to pick the chunk size from the input size and thread count.
+inline constexpr size_t auto_grain = 0;
+
+template <class R, class Fn>
+inline void for_each(R&& range, Fn fn, size_t grain = auto_grain) noexcept {
+    auto* _Data = std::data(range);
+    _DETAIL _Parallel_ranges(std::size(range), grain, [&](size_t begin, size_t end) {
+        for (size_t index = begin; index < end; ++index)
+            fn(_Data[index]);
+    });
+}
+
+// out[i] = fn(in[i]), `out` must be at least as large as `in` (it may be `in`).
+template <class In, class Out, class Fn>
+inline void transform(In&& in, Out&& out, Fn fn, size_t grain = auto_grain) noexcept {
+    panic(IF(std::size(out) < std::size(in)), "par::transform: output is smaller than the input ({} < {})", std::size(out), std::size(in));
+    auto* _Source = std::data(in);
+    auto* _Target = std::data(out);
+    _DETAIL _Parallel_ranges(std::size(in), grain, [&](size_t begin, size_t end) {
+        for (size_t index = begin; index < end; ++index)
+            _Target[index] = fn(_Source[index]);
+    });
+}
+
+/// <summary>
+/// Folds every element into `init` with `op`, which must be associative. Partial results
+/// are combined in order, so the result does not depend on scheduling.
+/// </summary>
+template <class R, class T, class Op = std::plus<>>
+_NODISCARD inline T reduce(R&& range, T init, Op op = Op{}, size_t grain = auto_grain) noexcept {
+    auto& _Pool = ThreadPool::global();
+    const size_t _Count = std::size(range);
+    if (grain == 0)
+        grain = _DETAIL _Default_grain(_Count, _Pool);
+    const size_t _Chunks = (_Count + grain - 1) / grain;
+    if (_Chunks <= 1) {
+        for (const auto& element : range)
+            init = op(std::move(init), element);
+        return init;
+    }
+
+    auto* _Data = std::data(range);
+    std::vector<std::optional<T>> _Partials(_Chunks);
+    _DETAIL _Parallel_chunks(_Chunks, [&](size_t chunk) {
+        const size_t _Begin = chunk * grain;
+        const size_t _End = std::min(_Begin + grain, _Count);
+        T _Sum = _Data[_Begin];
+        for (size_t index = _Begin + 1; index < _End; ++index)
+            _Sum = op(std::move(_Sum), _Data[index]);
+        _Partials[chunk].emplace(std::move(_Sum));
+    }, _Pool);
+
+    for (auto& partial : _Partials)
+        init = op(std::move(init), std::move(*partial));
+    return init;
+}
+
+/// <summary>
+/// out[i] = in[0] op in[1] op ... op in[i]. `out` may be `in`. Three passes: scan each chunk,
+/// scan the chunk totals, then fold each chunk's prefix into it.
+/// </summary>
+template <class In, class Out, class Op = std::plus<>>
+inline void inclusive_scan(In&& in, Out&& out, Op op = Op{}, size_t grain = auto_grain) noexcept {
+    panic(IF(std::size(out) < std::size(in)), "par::inclusive_scan: output is smaller than the input ({} < {})", std::size(out), std::size(in));
+    using T = std::remove_cvref_t<decltype(*std::data(out))>;
+    auto& _Pool = ThreadPool::global();
+    const size_t _Count = std::size(in);
+    if (_Count == 0)
+        return;
+    if (grain == 0)
+        grain = _DETAIL _Default_grain(_Count, _Pool);
+    const size_t _Chunks = (_Count + grain - 1) / grain;
+
+    auto* _Source = std::data(in);
+    auto* _Target = std::data(out);
+    auto _Scan = [&](size_t chunk) {
+        const size_t _Begin = chunk * grain;
+        const size_t _End = std::min(_Begin + grain, _Count);
+        T _Sum = _Source[_Begin];
+        _Target[_Begin] = _Sum;
+        for (size_t index = _Begin + 1; index < _End; ++index) {
+            _Sum = op(std::move(_Sum), _Source[index]);
+            _Target[index] = _Sum;
+        }
+    };
+    if (_Chunks == 1) {
+        _Scan(0);
+        return;
+    }
+    _DETAIL _Parallel_chunks(_Chunks, _Scan, _Pool);
+
+    // the prefix of chunk c is everything before it, chunk 0 has none.
+    std::vector<T> _Prefix;
+    _Prefix.reserve(_Chunks);
+    _Prefix.push_back(_Target[grain - 1]);
+    for (size_t chunk = 1; chunk + 1 < _Chunks; ++chunk)
+        _Prefix.push_back(op(_Prefix.back(), _Target[std::min((chunk + 1) * grain, _Count) - 1]));
+
+    _DETAIL _Parallel_chunks(_Chunks - 1, [&](size_t index) {
+        const size_t _Chunk = index + 1;
+        const size_t _Begin = _Chunk * grain;
+        const size_t _End = std::min(_Begin + grain, _Count);
+        const T& _Carry = _Prefix[index];
+        for (size_t position = _Begin; position < _End; ++position)
+            _Target[position] = op(_Carry, _Target[position]);
+    }, _Pool);
+}
+
+/// <summary>
+/// Parallel merge sort (not stable): chunks are sorted with std::sort, then merged pairwise.
+/// Every merge round is split along merge paths, so all threads stay busy through the last
+/// merge. Needs one temporary buffer the size of the input.
+/// </summary>
+template <class R, class Compare = std::less<>>
+inline void sort(R&& range, Compare compare = Compare{}, size_t grain = auto_grain) noexcept {
+    using T = std::remove_cvref_t<decltype(*std::data(range))>;
+    auto& _Pool = ThreadPool::global();
+    auto* _Data = std::data(range);
+    const size_t _Count = std::size(range);
+    if (grain == 0)
+        grain = std::max<size_t>(_DETAIL _Default_grain(_Count, _Pool), 1 << 14);
+    if (_Count <= grain) {
+        std::sort(_Data, _Data + _Count, compare);
+        return;
+    }
+
+    const size_t _Chunks = (_Count + grain - 1) / grain;
+    _DETAIL _Parallel_chunks(_Chunks, [&](size_t chunk) {
+        const size_t _Begin = chunk * grain;
+        std::sort(_Data + _Begin, _Data + std::min(_Begin + grain, _Count), compare);
+    }, _Pool);
+
+    std::vector<T> _Buffer(_Count);
+    T* _From = _Data;
+    T* _To = _Buffer.data();
+    const size_t _Pieces_per_merge_target = (_Pool.thread_count() + 1) * 2;
+
+    for (size_t width = grain; width < _Count; width *= 2) {
+        const size_t _Pairs = (_Count + 2 * width - 1) / (2 * width);
+        // enough pieces in total to occupy every thread, each at least a grain long.
+        const size_t _Pieces = std::max<size_t>(1, std::min(_Pieces_per_merge_target / _Pairs + 1, (2 * width) / grain));
+
+        _DETAIL _Parallel_chunks(_Pairs * _Pieces, [&](size_t task) {
+            const size_t _Pair = task / _Pieces;
+            const size_t _Piece = task % _Pieces;
+
+            const size_t _Left = _Pair * 2 * width;
+            const size_t _Middle = std::min(_Left + width, _Count);
+            const size_t _Right = std::min(_Left + 2 * width, _Count);
+            T* _A = _From + _Left;
+            T* _B = _From + _Middle;
+            const size_t _A_size = _Middle - _Left;
+            const size_t _B_size = _Right - _Middle;
+            const size_t _Total = _A_size + _B_size;
+
+            const size_t _Out_begin = _Total * _Piece / _Pieces;
+            const size_t _Out_end = _Total * (_Piece + 1) / _Pieces;
+            const size_t _A_begin = _DETAIL _Merge_path(_A, _A_size, _B, _B_size, _Out_begin, compare);
+            const size_t _A_end = _DETAIL _Merge_path(_A, _A_size, _B, _B_size, _Out_end, compare);
+
+            std::merge(std::make_move_iterator(_A + _A_begin), std::make_move_iterator(_A + _A_end),
+                       std::make_move_iterator(_B + (_Out_begin - _A_begin)), std::make_move_iterator(_B + (_Out_end - _A_end)),
+                       _To + _Left + _Out_begin, compare);
+        }, _Pool);
+        std::swap(_From, _To);
+    }
+
+    if (_From != _Data)
+        _DETAIL _Parallel_ranges(_Count, 0, [&](size_t begin, size_t end) {
+            std::move(_From + begin, _From + end, _Data + begin);
+        }, _Pool);
+}
+
+} // namespace par
+
+_STD_API_END
+
+#define _STD_PARALLEL
+#endif
@@ -0,0 +1,453 @@
+
+#ifndef _STD_QUEUE
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <span>
+#include <utility>
+
+#include "forward.hpp"
+#include "stddef.hpp"
+#include "panic.hpp"
+#include "option.hpp"
+#include "iterator.hpp"
+
+_STD_DETAIL_API
+
+// Keeps the producer and consumer indices of a RingBuffer off each other's cache line.
+inline constexpr size_t _Queue_cache_line = 64;
+
+_STD_API_END
+
+_STD_API_BEGIN
+
+enum class RingBufferMode {
+    // push() fails when the buffer is full.
+    Reject,
+    // push() drops the oldest element when the buffer is full.
+    Overwrite,
+};
+
+/// <summary>
+/// A fixed capacity FIFO. The capacity is rounded up to a power of two, so a slot is found
+/// with a mask instead of a division, and the read and write positions only ever count up.
+///
+/// With RingBufferMode::Reject one thread may push while another pops without any lock:
+/// each side owns its index, and the indices sit on separate cache lines. Overwrite mode
+/// has push() move the read position too, so it is single threaded only, as are indexing
+/// and iteration while the other side is running.
+/// </summary>
+template <class T>
+class RingBuffer {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "RingBuffer storage comes from malloc, over-aligned types are not supported.");
+public:
+    using value_type = T;
+    using iterator = _DETAIL _Index_iterator<RingBuffer, T>;
+    using const_iterator = _DETAIL _Index_iterator<const RingBuffer, const T>;
+private:
+    T* _Slots{ nullptr };
+    size_t _Mask{ 0 };
+    RingBufferMode _Mode;
+    // next position to pop, written by the consumer.
+    alignas(_DETAIL _Queue_cache_line) std::atomic<size_t> _Read{ 0 };
+    // next position to push, written by the producer.
+    alignas(_DETAIL _Queue_cache_line) std::atomic<size_t> _Write{ 0 };
+public:
+    _STD_MAKE_NONCOPYABLE(RingBuffer);
+    _STD_MAKE_NONMOVEABLE(RingBuffer);
+
+    inline explicit RingBuffer(size_t capacity, RingBufferMode mode = RingBufferMode::Reject) noexcept
+        : _Mode(mode)
+    {
+        panic(IF(capacity == 0), "RingBuffer: capacity must be at least one.");
+        const size_t _Capacity = std::bit_ceil(capacity);
+        _Slots = static_cast<T*>(::malloc(sizeof(T) * _Capacity));
+        panic(IF(_Slots == nullptr), "RingBuffer: failed to allocate {} slots.", _Capacity);
+        _Mask = _Capacity - 1;
+    }
+    inline ~RingBuffer() noexcept {
+        clear();
+        ::free(_Slots);
+    }
+
+    // false when the buffer is full (never in overwrite mode).
+    inline bool push(T&& value) noexcept {
+        return emplace(std::move(value));
+    }
+    inline bool push(const T& value) noexcept {
+        return emplace(value);
+    }
+
+    template <typename... Ts>
+    inline bool emplace(Ts&&... args) noexcept {
+        const size_t _Write_pos = _Write.load(std::memory_order_relaxed);
+        size_t _Read_pos = _Read.load(std::memory_order_acquire);
+        if (_Write_pos - _Read_pos > _Mask) {
+            if (_Mode == RingBufferMode::Reject)
+                return false;
+            _Slots[_Read_pos & _Mask].~T();
+            _Read.store(++_Read_pos, std::memory_order_relaxed);
+        }
+        ::new (static_cast<void*>(_Slots + (_Write_pos & _Mask))) T(std::forward<Ts>(args)...);
+        _Write.store(_Write_pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // none when the buffer is empty.
+    _NODISCARD inline Option<T> pop() noexcept {
+        const size_t _Read_pos = _Read.load(std::memory_order_relaxed);
+        if (_Read_pos == _Write.load(std::memory_order_acquire))
+            return none;
+        T* _Slot = _Slots + (_Read_pos & _Mask);
+        T _Value = std::move(*_Slot);
+        _Slot->~T();
+        _Read.store(_Read_pos + 1, std::memory_order_release);
+        return Option<T>(std::move(_Value));
+    }
+
+    // The oldest and the newest element, nullptr when empty.
+    _NODISCARD inline T* front() noexcept {
+        return empty() ? nullptr : _Slots + (_Read.load(std::memory_order_relaxed) & _Mask);
+    }
+    _NODISCARD inline const T* front() const noexcept {
+        return empty() ? nullptr : _Slots + (_Read.load(std::memory_order_relaxed) & _Mask);
+    }
+    _NODISCARD inline T* back() noexcept {
+        return empty() ? nullptr : _Slots + ((_Write.load(std::memory_order_relaxed) - 1) & _Mask);
+    }
+    _NODISCARD inline const T* back() const noexcept {
+        return empty() ? nullptr : _Slots + ((_Write.load(std::memory_order_relaxed) - 1) & _Mask);
+    }
+
+    // index 0 is the oldest element.
+    _NODISCARD inline T& operator[](size_t index) noexcept {
+        return _Slots[(_Read.load(std::memory_order_relaxed) + index) & _Mask];
+    }
+    _NODISCARD inline const T& operator[](size_t index) const noexcept {
+        return _Slots[(_Read.load(std::memory_order_relaxed) + index) & _Mask];
+    }
+    _NODISCARD inline T& at(size_t index) noexcept {
+        panic(IF(index >= size()), "RingBuffer::at(): index {} is out of range for size {}.", index, size());
+        return (*this)[index];
+    }
+    _NODISCARD inline const T& at(size_t index) const noexcept {
+        panic(IF(index >= size()), "RingBuffer::at(): index {} is out of range for size {}.", index, size());
+        return (*this)[index];
+    }
+
+    inline void clear() noexcept {
+        while (!empty())
+            (void)pop();
+    }
+
+    _NODISCARD inline size_t size() const noexcept {
+        return _Write.load(std::memory_order_acquire) - _Read.load(std::memory_order_acquire);
+    }
+    _NODISCARD inline size_t capacity() const noexcept {
+        return _Mask + 1;
+    }
+    _NODISCARD inline bool empty() const noexcept {
+        return size() == 0;
+    }
+    _NODISCARD inline bool full() const noexcept {
+        return size() == capacity();
+    }
+
+    // Oldest first.
+    _NODISCARD inline iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+    _NODISCARD inline iterator end() noexcept {
+        return iterator(this, size());
+    }
+    _NODISCARD inline const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+    _NODISCARD inline const_iterator end() const noexcept {
+        return const_iterator(this, size());
+    }
+};
+
+/// <summary>
+/// A double ended queue of fixed size segments. Pushing at either end never moves an
+/// element; growth only reallocates the small table of segment pointers. The segment
+/// emptied last is kept as a spare, so a queue that is pushed at one end and popped at the
+/// other settles into allocating nothing.
+///
+/// Indexing is a shift and a mask into the segment table. Not thread safe, use
+/// RingBuffer when a producer and a consumer run concurrently.
+/// </summary>
+template <class T>
+class Deque {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "Deque segments come from malloc, over-aligned types are not supported.");
+public:
+    using value_type = T;
+    using iterator = _DETAIL _Index_iterator<Deque, T>;
+    using const_iterator = _DETAIL _Index_iterator<const Deque, const T>;
+
+    static constexpr size_t segment_size = _DETAIL _Segment_size<T>;
+private:
+    static constexpr size_t _Shift = std::countr_zero(segment_size);
+    static constexpr size_t _Mask = segment_size - 1;
+
+    T** _Segments{ nullptr };
+    size_t _Segment_count{ 0 };
+    // absolute position of the first element, (segment << _Shift) | offset.
+    size_t _First{ 0 };
+    size_t _Size{ 0 };
+    T* _Spare{ nullptr };
+public:
+    Deque() noexcept = default;
+    inline Deque(std::initializer_list<T> init) noexcept {
+        for (const auto& element : init)
+            push_back(element);
+    }
+    inline Deque(const Deque& other) noexcept {
+        for (const auto& element : other)
+            push_back(element);
+    }
+    inline Deque(Deque&& other) noexcept {
+        swap(other);
+    }
+    inline Deque& operator=(const Deque& other) noexcept {
+        if (this != &other) {
+            Deque _Copy(other);
+            swap(_Copy);
+        }
+        return *this;
+    }
+    inline Deque& operator=(Deque&& other) noexcept {
+        if (this != &other) {
+            Deque _Moved(std::move(other));
+            swap(_Moved);
+        }
+        return *this;
+    }
+    inline ~Deque() noexcept {
+        clear();
+        ::free(_Spare);
+        ::free(_Segments);
+    }
+
+    inline T& push_back(T&& value) noexcept {
+        return emplace_back(std::move(value));
+    }
+    inline T& push_back(const T& value) noexcept {
+        return emplace_back(value);
+    }
+    inline T& push_front(T&& value) noexcept {
+        return emplace_front(std::move(value));
+    }
+    inline T& push_front(const T& value) noexcept {
+        return emplace_front(value);
+    }
+
+    template <typename... Ts>
+    inline T& emplace_back(Ts&&... args) noexcept {
+        const size_t _Position = _First + _Size;
+        if ((_Position >> _Shift) >= _Segment_count) {
+            _Remap(false);
+            return emplace_back(std::forward<Ts>(args)...);
+        }
+        T* _Slot = ::new (static_cast<void*>(_Segment_for(_Position) + (_Position & _Mask))) T(std::forward<Ts>(args)...);
+        ++_Size;
+        return *_Slot;
+    }
+
+    template <typename... Ts>
+    inline T& emplace_front(Ts&&... args) noexcept {
+        if (_First == 0) {
+            _Remap(true);
+            return emplace_front(std::forward<Ts>(args)...);
+        }
+        const size_t _Position = _First - 1;
+        T* _Slot = ::new (static_cast<void*>(_Segment_for(_Position) + (_Position & _Mask))) T(std::forward<Ts>(args)...);
+        _First = _Position;
+        ++_Size;
+        return *_Slot;
+    }
+
+    _NODISCARD inline T pop_front() noexcept {
+        panic(IF(_Size == 0), "cannot pop from an empty deque.");
+        T& _Slot = (*this)[0];
+        T _Value = std::move(_Slot);
+        _Slot.~T();
+        ++_First;
+        --_Size;
+        if ((_First & _Mask) == 0 || _Size == 0)
+            _Retire_segment((_First - 1) >> _Shift);
+        return _Value;
+    }
+
+    _NODISCARD inline T pop_back() noexcept {
+        panic(IF(_Size == 0), "cannot pop from an empty deque.");
+        T& _Slot = (*this)[_Size - 1];
+        T _Value = std::move(_Slot);
+        _Slot.~T();
+        --_Size;
+        const size_t _Position = _First + _Size;
+        if ((_Position & _Mask) == 0 || _Size == 0)
+            _Retire_segment(_Position >> _Shift);
+        return _Value;
+    }
+
+    _NODISCARD inline T& operator[](size_t index) noexcept {
+        const size_t _Position = _First + index;
+        return _Segments[_Position >> _Shift][_Position & _Mask];
+    }
+    _NODISCARD inline const T& operator[](size_t index) const noexcept {
+        const size_t _Position = _First + index;
+        return _Segments[_Position >> _Shift][_Position & _Mask];
+    }
+    _NODISCARD inline T& at(size_t index) noexcept {
+        panic(IF(index >= _Size), "Deque::at(): index {} is out of range for size {}.", index, _Size);
+        return (*this)[index];
+    }
+    _NODISCARD inline const T& at(size_t index) const noexcept {
+        panic(IF(index >= _Size), "Deque::at(): index {} is out of range for size {}.", index, _Size);
+        return (*this)[index];
+    }
+
+    _NODISCARD inline T& front() noexcept {
+        panic(IF(_Size == 0), "Deque::front(): the deque is empty.");
+        return (*this)[0];
+    }
+    _NODISCARD inline const T& front() const noexcept {
+        panic(IF(_Size == 0), "Deque::front(): the deque is empty.");
+        return (*this)[0];
+    }
+    _NODISCARD inline T& back() noexcept {
+        panic(IF(_Size == 0), "Deque::back(): the deque is empty.");
+        return (*this)[_Size - 1];
+    }
+    _NODISCARD inline const T& back() const noexcept {
+        panic(IF(_Size == 0), "Deque::back(): the deque is empty.");
+        return (*this)[_Size - 1];
+    }
+
+    /// <summary>
+    /// Calls fn(std::span<T>) for each contiguous run of elements, front to back, for loops
+    /// that want to vectorize over whole segments.
+    /// </summary>
+    template <class Fn>
+    inline void for_each_segment(Fn&& fn) {
+        size_t _Position = _First;
+        const size_t _End = _First + _Size;
+        while (_Position != _End) {
+            const size_t _Run = std::min(segment_size - (_Position & _Mask), _End - _Position);
+            fn(std::span<T>(_Segments[_Position >> _Shift] + (_Position & _Mask), _Run));
+            _Position += _Run;
+        }
+    }
+
+    // Destroys every element, keeping the segment table.
+    inline void clear() noexcept {
+        while (_Size != 0)
+            (void)pop_back();
+    }
+
+    _NODISCARD inline size_t size() const noexcept {
+        return _Size;
+    }
+    _NODISCARD inline bool empty() const noexcept {
+        return _Size == 0;
+    }
+
+    _NODISCARD inline iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+    _NODISCARD inline iterator end() noexcept {
+        return iterator(this, _Size);
+    }
+    _NODISCARD inline const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+    _NODISCARD inline const_iterator end() const noexcept {
+        return const_iterator(this, _Size);
+    }
+
+    inline void swap(Deque& other) noexcept {
+        std::swap(_Segments, other._Segments);
+        std::swap(_Segment_count, other._Segment_count);
+        std::swap(_First, other._First);
+        std::swap(_Size, other._Size);
+        std::swap(_Spare, other._Spare);
+    }
+    friend inline void swap(Deque& left, Deque& right) noexcept {
+        left.swap(right);
+    }
+
+private:
+    // The segment holding `position`, allocated (or taken from the spare) on first use.
+    _NODISCARD inline T* _Segment_for(size_t position) noexcept {
+        T*& _Segment = _Segments[position >> _Shift];
+        if (_Segment == nullptr) {
+            if (_Spare != nullptr) {
+                _Segment = std::exchange(_Spare, nullptr);
+            }
+            else {
+                _Segment = static_cast<T*>(::malloc(sizeof(T) * segment_size));
+                panic(IF(_Segment == nullptr), "Deque: failed to allocate a segment of {} elements.", segment_size);
+            }
+        }
+        return _Segment;
+    }
+
+    // A segment no element lives in any more: keep one as the spare, free the rest.
+    inline void _Retire_segment(size_t segment) noexcept {
+        T* _Segment = std::exchange(_Segments[segment], nullptr);
+        if (_Spare == nullptr)
+            _Spare = _Segment;
+        else
+            ::free(_Segment);
+    }
+
+    /// <summary>
+    /// Called when an end runs out of table: recentres the used segments in the table,
+    /// doubling it first when it is more than half in use, so both ends have room again.
+    /// </summary>
+    inline void _Remap(bool front) noexcept {
+        const size_t _Used_first = _First >> _Shift;
+        const size_t _Used_count = _Size == 0 ? 0 : ((_First + _Size - 1) >> _Shift) - _Used_first + 1;
+        size_t _New_count = _Segment_count;
+        if (_New_count < 8 || (_Used_count + 1) * 2 > _New_count)
+            _New_count = std::max<size_t>(8, _Segment_count * 2);
+
+        // bias the free space towards the end that ran out.
+        size_t _New_first = (_New_count - _Used_count) / 2;
+        if (front && _New_first == 0)
+            _New_first = 1;
+
+        T** _Table = _Segments;
+        if (_New_count != _Segment_count) {
+            _Table = static_cast<T**>(::calloc(_New_count, sizeof(T*)));
+            panic(IF(_Table == nullptr), "Deque: failed to allocate a table of {} segments.", _New_count);
+            for (size_t index = 0; index < _Used_count; ++index)
+                _Table[_New_first + index] = _Segments[_Used_first + index];
+            ::free(_Segments);
+        }
+        else {
+            std::memmove(_Table + _New_first, _Table + _Used_first, _Used_count * sizeof(T*));
+            // clear whatever slots the move left behind outside the new used range.
+            for (size_t index = 0; index < _Segment_count; ++index) {
+                if (index < _New_first || index >= _New_first + _Used_count)
+                    _Table[index] = nullptr;
+            }
+        }
+        _Segments = _Table;
+        _Segment_count = _New_count;
+        _First = (_New_first << _Shift) | (_First & _Mask);
+    }
+};
+
+_STD_API_END
+
+#define _STD_QUEUE
+#endif
@@ -0,0 +1,277 @@
+
+#ifndef _STD_RADIX
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+#include "forward.hpp"
+#include "stddef.hpp"
+#include "parallel.hpp"
+#include "panic.hpp"
+
+_STD_DETAIL_API
+
+// The key itself, for sorting plain integers and floats.
+struct _Radix_identity {
+    template <class T>
+    _STD_API const T& operator()(const T& value) const noexcept {
+        return value;
+    }
+};
+
+// bool has no byte layout worth sorting on, sort by an integer key instead.
+template <class K>
+concept _Radix_key = (std::is_integral_v<K> && !std::is_same_v<K, bool>) || std::is_floating_point_v<K> || std::is_enum_v<K>;
+
+// Map a key to an unsigned integer with the same ordering.
+template <class K>
+_STD_API auto _Radix_bits(K key) noexcept {
+    if constexpr (std::is_enum_v<K>) {
+        return _Radix_bits(static_cast<std::underlying_type_t<K>>(key));
+    }
+    else if constexpr (std::is_floating_point_v<K>) {
+        using _Bits = std::conditional_t<sizeof(K) == 4, uint32, uint64>;
+        constexpr _Bits _Sign = _Bits{ 1 } << (sizeof(K) * 8 - 1);
+        const auto _Raw = std::bit_cast<_Bits>(key);
+        // negatives run backwards, flip all of them. positives just move above the negatives.
+        return (_Raw & _Sign) ? static_cast<_Bits>(~_Raw) : static_cast<_Bits>(_Raw | _Sign);
+    }
+    else if constexpr (std::is_signed_v<K>) {
+        using _Bits = std::make_unsigned_t<K>;
+        return static_cast<_Bits>(static_cast<_Bits>(key) ^ (_Bits{ 1 } << (sizeof(K) * 8 - 1)));
+    }
+    else {
+        return static_cast<std::make_unsigned_t<K>>(key);
+    }
+}
+
+/// <summary>
+/// Scratch space for the scatter passes. Every slot is written by memcpy before it is read,
+/// so the storage is left uninitialized and T does not need a default constructor.
+/// </summary>
+template <class T>
+class _Radix_buffer {
+public:
+    _STD_MAKE_NONCOPYABLE(_Radix_buffer);
+    _STD_MAKE_NONMOVEABLE(_Radix_buffer);
+
+    explicit _Radix_buffer(size_t count) noexcept
+        : _Data(static_cast<T*>(::operator new(sizeof(T) * count, std::align_val_t{ alignof(T) }, std::nothrow))) {
+        panic(IF(_Data == nullptr), "radix_sort(): failed to allocate a buffer of {} elements.", count);
+    }
+    ~_Radix_buffer() noexcept {
+        ::operator delete(_Data, std::align_val_t{ alignof(T) });
+    }
+
+    _NODISCARD T* data() const noexcept { return _Data; }
+
+private:
+    T* _Data;
+};
+
+_STD_INLINE void _Radix_prefetch(const void* address) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#elif defined(_M_X64) || defined(_M_IX86)
+    _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#endif
+}
+
+// How far ahead of the current element the input is prefetched.
+inline constexpr size_t _Radix_prefetch_distance = 64;
+
+/// <summary>
+/// Counts for every byte of the key in one read of the input: counts[pass][byte].
+/// </summary>
+template <class T, class KeyFn, size_t Passes>
+_STD_INLINE void _Radix_histograms(const T* data, size_t count, const KeyFn& key_of, size_t(&counts)[Passes][256]) noexcept {
+    for (size_t index = 0; index < count; ++index) {
+        if (index + _Radix_prefetch_distance < count)
+            _Radix_prefetch(data + index + _Radix_prefetch_distance);
+        const auto _Key = _Radix_bits(key_of(data[index]));
+        for (size_t pass = 0; pass < Passes; ++pass)
+            ++counts[pass][(_Key >> (pass * 8)) & 0xFF];
+    }
+}
+
+// A byte that is the same in every key sorts nothing, its pass can be skipped.
+template <size_t Passes>
+_STD_INLINE bool _Radix_pass_is_constant(const size_t(&counts)[Passes][256], size_t pass, size_t count) noexcept {
+    for (size_t byte = 0; byte < 256; ++byte) {
+        if (counts[pass][byte] != 0)
+            return counts[pass][byte] == count;
+    }
+    return true;
+}
+
+template <class KeyFn, class T>
+using _Radix_key_type = std::remove_cvref_t<decltype(std::declval<const KeyFn&>()(std::declval<const T&>()))>;
+
+template <class KeyFn, class T>
+using _Radix_key_bits = decltype(_Radix_bits(std::declval<_Radix_key_type<KeyFn, T>>()));
+
+_STD_API_END
+
+_STD_API_BEGIN
+
+/// <summary>
+/// Stable LSD radix sort, one byte of the key per pass, for integers, floats, enums, or
+/// records sorted by such a key (key_of(record)). Every histogram comes from a single read
+/// of the input, and passes over a byte that is the same in every key are skipped, so
+/// small keys in wide types cost only the passes they need. Floats order -0.0 before 0.0.
+/// Records must be trivially copyable, one temporary buffer of the input size is used.
+/// </summary>
+template <class R, class KeyFn = _DETAIL _Radix_identity>
+inline void radix_sort(R&& range, KeyFn key_of = KeyFn{}) noexcept {
+    using T = std::remove_cvref_t<decltype(*std::data(range))>;
+    static_assert(std::is_trivially_copyable_v<T>, "radix_sort() moves records with memcpy, T must be trivially copyable.");
+    static_assert(_DETAIL _Radix_key<_DETAIL _Radix_key_type<KeyFn, T>>, "radix_sort() keys must be integers (not bool), floats or enums.");
+    constexpr size_t _Passes = sizeof(_DETAIL _Radix_key_bits<KeyFn, T>);
+
+    T* _Data = std::data(range);
+    const size_t _Count = std::size(range);
+    if (_Count < 2)
+        return;
+
+    size_t _Counts[_Passes][256] = {};
+    _DETAIL _Radix_histograms(_Data, _Count, key_of, _Counts);
+
+    _DETAIL _Radix_buffer<T> _Buffer(_Count);
+    T* _From = _Data;
+    T* _To = _Buffer.data();
+
+    for (size_t pass = 0; pass < _Passes; ++pass) {
+        if (_DETAIL _Radix_pass_is_constant(_Counts, pass, _Count))
+            continue;
+
+        size_t _Offsets[256];
+        size_t _Sum = 0;
+        for (size_t byte = 0; byte < 256; ++byte) {
+            _Offsets[byte] = _Sum;
+            _Sum += _Counts[pass][byte];
+        }
+
+        const size_t _Shift = pass * 8;
+        for (size_t index = 0; index < _Count; ++index) {
+            if (index + _DETAIL _Radix_prefetch_distance < _Count)
+                _DETAIL _Radix_prefetch(_From + index + _DETAIL _Radix_prefetch_distance);
+            const size_t _Byte = (_DETAIL _Radix_bits(key_of(_From[index])) >> _Shift) & 0xFF;
+            std::memcpy(_To + _Offsets[_Byte]++, _From + index, sizeof(T));
+        }
+        std::swap(_From, _To);
+    }
+
+    if (_From != _Data)
+        std::memcpy(_Data, _From, _Count * sizeof(T));
+}
+
+namespace par {
+
+/// <summary>
+/// radix_sort() split across ThreadPool::global(). The input is cut into one slice per
+/// thread, each pass histograms its slice, the per-thread counts are turned into
+/// (byte, thread) offsets, and every thread scatters its own slice. Still stable.
+/// Falls back to the serial sort for inputs under `grain` elements.
+/// </summary>
+template <class R, class KeyFn = _DETAIL _Radix_identity>
+inline void radix_sort(R&& range, KeyFn key_of = KeyFn{}, size_t grain = auto_grain) noexcept {
+    using T = std::remove_cvref_t<decltype(*std::data(range))>;
+    static_assert(std::is_trivially_copyable_v<T>, "radix_sort() moves records with memcpy, T must be trivially copyable.");
+    static_assert(_DETAIL _Radix_key<_DETAIL _Radix_key_type<KeyFn, T>>, "radix_sort() keys must be integers (not bool), floats or enums.");
+    constexpr size_t _Passes = sizeof(_DETAIL _Radix_key_bits<KeyFn, T>);
+    using _Histogram = size_t[_Passes][256];
+
+    auto& _Pool = ThreadPool::global();
+    T* _Data = std::data(range);
+    const size_t _Count = std::size(range);
+    if (grain == 0)
+        grain = 1 << 16;
+    const size_t _Slices = std::min(_Pool.thread_count() + 1, (_Count + grain - 1) / grain);
+    if (_Slices <= 1) {
+        stud::radix_sort(range, key_of);
+        return;
+    }
+
+    auto _Slice_begin = [&](size_t slice) { return _Count * slice / _Slices; };
+
+    // full histograms of every slice, summed, decide which passes can be skipped.
+    std::vector<std::remove_all_extents_t<_Histogram>> _Storage(_Slices * _Passes * 256);
+    auto _Slice_counts = [&](size_t slice) -> _Histogram& {
+        return *reinterpret_cast<_Histogram*>(_Storage.data() + slice * _Passes * 256);
+    };
+    _DETAIL _Parallel_chunks(_Slices, [&](size_t slice) {
+        _DETAIL _Radix_histograms(_Data + _Slice_begin(slice), _Slice_begin(slice + 1) - _Slice_begin(slice), key_of, _Slice_counts(slice));
+    }, _Pool);
+
+    size_t _Totals[_Passes][256] = {};
+    for (size_t slice = 0; slice < _Slices; ++slice)
+        for (size_t pass = 0; pass < _Passes; ++pass)
+            for (size_t byte = 0; byte < 256; ++byte)
+                _Totals[pass][byte] += _Slice_counts(slice)[pass][byte];
+
+    _DETAIL _Radix_buffer<T> _Buffer(_Count);
+    T* _From = _Data;
+    T* _To = _Buffer.data();
+    std::vector<size_t> _Offsets(_Slices * 256);
+    bool _First_pass = true;
+
+    for (size_t pass = 0; pass < _Passes; ++pass) {
+        if (_DETAIL _Radix_pass_is_constant(_Totals, pass, _Count))
+            continue;
+        const size_t _Shift = pass * 8;
+
+        // after the first real pass the slices hold different records, count this byte again.
+        if (!_First_pass) {
+            _DETAIL _Parallel_chunks(_Slices, [&](size_t slice) {
+                auto& _Counts = _Slice_counts(slice)[pass];
+                std::fill(std::begin(_Counts), std::end(_Counts), size_t{ 0 });
+                for (size_t index = _Slice_begin(slice); index < _Slice_begin(slice + 1); ++index)
+                    ++_Counts[(_DETAIL _Radix_bits(key_of(_From[index])) >> _Shift) & 0xFF];
+            }, _Pool);
+        }
+        _First_pass = false;
+
+        // byte major, slice minor: records keep their order within every byte.
+        size_t _Sum = 0;
+        for (size_t byte = 0; byte < 256; ++byte) {
+            for (size_t slice = 0; slice < _Slices; ++slice) {
+                _Offsets[slice * 256 + byte] = _Sum;
+                _Sum += _Slice_counts(slice)[pass][byte];
+            }
+        }
+
+        _DETAIL _Parallel_chunks(_Slices, [&](size_t slice) {
+            size_t* _Next = _Offsets.data() + slice * 256;
+            const size_t _End = _Slice_begin(slice + 1);
+            for (size_t index = _Slice_begin(slice); index < _End; ++index) {
+                if (index + _DETAIL _Radix_prefetch_distance < _End)
+                    _DETAIL _Radix_prefetch(_From + index + _DETAIL _Radix_prefetch_distance);
+                const size_t _Byte = (_DETAIL _Radix_bits(key_of(_From[index])) >> _Shift) & 0xFF;
+                std::memcpy(_To + _Next[_Byte]++, _From + index, sizeof(T));
+            }
+        }, _Pool);
+        std::swap(_From, _To);
+    }
+
+    if (_From != _Data) {
+        _DETAIL _Parallel_chunks(_Slices, [&](size_t slice) {
+            std::memcpy(_Data + _Slice_begin(slice), _From + _Slice_begin(slice), (_Slice_begin(slice + 1) - _Slice_begin(slice)) * sizeof(T));
+        }, _Pool);
+    }
+}
+
+} // namespace par
+
+_STD_API_END
+
+#define _STD_RADIX
+#endif
@@ -0,0 +1,461 @@
+
+#ifndef _STD_RANGES
+
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "forward.hpp"
+#include "stddef.hpp"
+#include "algorithm.hpp"
+
+_STD_DETAIL_API
+
+/// <summary>
+/// How a view holds what it adapts: containers passed as lvalues are referenced,
+/// temporaries (usually other views) are moved into the view.
+/// </summary>
+template <class R>
+class _Range_holder {
+private:
+    using _Stored = std::conditional_t<std::is_lvalue_reference_v<R>, std::remove_reference_t<R>*, std::remove_cvref_t<R>>;
+    _Stored _Range;
+public:
+    template <class Arg>
+    inline explicit _Range_holder(Arg&& range) noexcept
+        : _Range(_Hold(std::forward<Arg>(range)))
+    {}
+
+    template <class Arg>
+    _NODISCARD static inline _Stored _Hold(Arg&& range) noexcept {
+        if constexpr (std::is_lvalue_reference_v<R>)
+            return std::addressof(range);
+        else
+            return _Stored(std::move(range));
+    }
+
+    _NODISCARD inline auto& get() noexcept {
+        if constexpr (std::is_lvalue_reference_v<R>)
+            return *_Range;
+        else
+            return _Range;
+    }
+};
+
+template <class R>
+_Range_holder(R&&) -> _Range_holder<R&&>;
+
+template <class R>
+using _Range_iterator = decltype(std::begin(std::declval<R&>()));
+template <class R>
+using _Range_sentinel = decltype(std::end(std::declval<R&>()));
+template <class R>
+using _Range_reference = decltype(*std::declval<_Range_iterator<R>&>());
+
+// `range | adaptor(args)` calls the adaptor with the range in front of its arguments.
+template <class Fn>
+struct _Range_pipe {
+    Fn _Apply;
+
+    template <class R>
+    friend inline auto operator|(R&& range, _Range_pipe pipe) noexcept {
+        return pipe._Apply(std::forward<R>(range));
+    }
+};
+
+template <class Fn>
+_Range_pipe(Fn) -> _Range_pipe<Fn>;
+
+_STD_API_END
+
+_STD_API_BEGIN
+
+/// <summary>
+/// A view over [begin, begin + count), stopping early at `end`. chunk() yields these.
+/// </summary>
+template <class It, class End>
+class CountedRange {
+private:
+    It _First;
+    End _Last;
+    size_t _Count;
+public:
+    class iterator {
+    private:
+        It _Current;
+        End _Last;
+        size_t _Left;
+    public:
+        using value_type = std::iter_value_t<It>;
+        using difference_type = ptrdiff;
+
+        iterator() noexcept = default;
+        inline iterator(It current, End last, size_t left) noexcept
+            : _Current(current), _Last(last), _Left(left)
+        {}
+
+        _NODISCARD inline decltype(auto) operator*() const noexcept {
+            return *_Current;
+        }
+        inline iterator& operator++() noexcept {
+            ++_Current;
+            --_Left;
+            return *this;
+        }
+        inline void operator++(int) noexcept {
+            ++*this;
+        }
+        _NODISCARD inline bool operator==(std::default_sentinel_t) const noexcept {
+            return _Left == 0 || _Current == _Last;
+        }
+    };
+
+    inline CountedRange(It first, End last, size_t count) noexcept
+        : _First(first), _Last(last), _Count(count)
+    {}
+
+    _NODISCARD inline iterator begin() const noexcept {
+        return iterator(_First, _Last, _Count);
+    }
+    _NODISCARD inline std::default_sentinel_t end() const noexcept {
+        return {};
+    }
+};
+
+template <class R>
+class EnumerateView {
+private:
+    _DETAIL _Range_holder<R> _Range;
+public:
+    class iterator {
+    private:
+        _DETAIL _Range_iterator<R> _Current;
+        _DETAIL _Range_sentinel<R> _Last;
+        size_t _Index{ 0 };
+    public:
+        using value_type = pair<size_t, _DETAIL _Range_reference<R>>;
+        using difference_type = ptrdiff;
+
+        iterator() noexcept = default;
+        inline iterator(_DETAIL _Range_iterator<R> current, _DETAIL _Range_sentinel<R> last) noexcept
+            : _Current(current), _Last(last)
+        {}
+
+        _NODISCARD inline value_type operator*() const noexcept {
+            return { _Index, *_Current };
+        }
+        inline iterator& operator++() noexcept {
+            ++_Current;
+            ++_Index;
+            return *this;
+        }
+        inline void operator++(int) noexcept {
+            ++*this;
+        }
+        _NODISCARD inline bool operator==(std::default_sentinel_t) const noexcept {
+            return _Current == _Last;
+        }
+    };
+
+    template <class Arg>
+    inline explicit EnumerateView(Arg&& range) noexcept : _Range(std::forward<Arg>(range)) {}
+
+    _NODISCARD inline iterator begin() noexcept {
+        return iterator(std::begin(_Range.get()), std::end(_Range.get()));
+    }
+    _NODISCARD inline std::default_sentinel_t end() noexcept {
+        return {};
+    }
+};
+
+template <class R, class Fn>
+class MapView {
+private:
+    _DETAIL _Range_holder<R> _Range;
+    Fn _Map;
+public:
+    class iterator {
+    private:
+        _DETAIL _Range_iterator<R> _Current;
+        _DETAIL _Range_sentinel<R> _Last;
+        const Fn* _Map{ nullptr };
+    public:
+        using value_type = std::remove_cvref_t<std::invoke_result_t<const Fn&, _DETAIL _Range_reference<R>>>;
+        using difference_type = ptrdiff;
+
+        iterator() noexcept = default;
+        inline iterator(_DETAIL _Range_iterator<R> current, _DETAIL _Range_sentinel<R> last, const Fn* map) noexcept
+            : _Current(current), _Last(last), _Map(map)
+        {}
+
+        _NODISCARD inline decltype(auto) operator*() const {
+            return (*_Map)(*_Current);
+        }
+        inline iterator& operator++() noexcept {
+            ++_Current;
+            return *this;
+        }
+        inline void operator++(int) noexcept {
+            ++*this;
+        }
+        _NODISCARD inline bool operator==(std::default_sentinel_t) const noexcept {
+            return _Current == _Last;
+        }
+    };
+
+    template <class Arg>
+    inline MapView(Arg&& range, Fn map) noexcept : _Range(std::forward<Arg>(range)), _Map(std::move(map)) {}
+
+    _NODISCARD inline iterator begin() noexcept {
+        return iterator(std::begin(_Range.get()), std::end(_Range.get()), &_Map);
+    }
+    _NODISCARD inline std::default_sentinel_t end() noexcept {
+        return {};
+    }
+};
+
+template <class R, class Pred>
+class FilterView {
+private:
+    _DETAIL _Range_holder<R> _Range;
+    Pred _Predicate;
+public:
+    class iterator {
+    private:
+        _DETAIL _Range_iterator<R> _Current;
+        _DETAIL _Range_sentinel<R> _Last;
+        const Pred* _Predicate{ nullptr };
+
+        inline void _Satisfy() {
+            while (_Current != _Last && !(*_Predicate)(*_Current))
+                ++_Current;
+        }
+    public:
+        using value_type = std::iter_value_t<_DETAIL _Range_iterator<R>>;
+        using difference_type = ptrdiff;
+
+        iterator() noexcept = default;
+        inline iterator(_DETAIL _Range_iterator<R> current, _DETAIL _Range_sentinel<R> last, const Pred* predicate)
+            : _Current(current), _Last(last), _Predicate(predicate)
+        {
+            _Satisfy();
+        }
+
+        _NODISCARD inline decltype(auto) operator*() const noexcept {
+            return *_Current;
+        }
+        inline iterator& operator++() {
+            ++_Current;
+            _Satisfy();
+            return *this;
+        }
+        inline void operator++(int) {
+            ++*this;
+        }
+        _NODISCARD inline bool operator==(std::default_sentinel_t) const noexcept {
+            return _Current == _Last;
+        }
+    };
+
+    template <class Arg>
+    inline FilterView(Arg&& range, Pred predicate) noexcept : _Range(std::forward<Arg>(range)), _Predicate(std::move(predicate)) {}
+
+    // Walks up to the first match, call it once per iteration.
+    _NODISCARD inline iterator begin() {
+        return iterator(std::begin(_Range.get()), std::end(_Range.get()), &_Predicate);
+    }
+    _NODISCARD inline std::default_sentinel_t end() noexcept {
+        return {};
+    }
+};
+
+template <class R>
+class TakeView {
+private:
+    _DETAIL _Range_holder<R> _Range;
+    size_t _Count;
+public:
+    template <class Arg>
+    inline TakeView(Arg&& range, size_t count) noexcept : _Range(std::forward<Arg>(range)), _Count(count) {}
+
+    _NODISCARD inline auto begin() noexcept {
+        return typename CountedRange<_DETAIL _Range_iterator<R>, _DETAIL _Range_sentinel<R>>::iterator(
+            std::begin(_Range.get()), std::end(_Range.get()), _Count);
+    }
+    _NODISCARD inline std::default_sentinel_t end() noexcept {
+        return {};
+    }
+};
+
+// Pairs up elements of two ranges, stops at the end of the shorter one.
+template <class L, class R>
+class ZipView {
+private:
+    _DETAIL _Range_holder<L> _Left;
+    _DETAIL _Range_holder<R> _Right;
+public:
+    class iterator {
+    private:
+        _DETAIL _Range_iterator<L> _Left_current;
+        _DETAIL _Range_sentinel<L> _Left_last;
+        _DETAIL _Range_iterator<R> _Right_current;
+        _DETAIL _Range_sentinel<R> _Right_last;
+    public:
+        using value_type = pair<_DETAIL _Range_reference<L>, _DETAIL _Range_reference<R>>;
+        using difference_type = ptrdiff;
+
+        iterator() noexcept = default;
+        inline iterator(_DETAIL _Range_iterator<L> left, _DETAIL _Range_sentinel<L> left_last,
+                        _DETAIL _Range_iterator<R> right, _DETAIL _Range_sentinel<R> right_last) noexcept
+            : _Left_current(left), _Left_last(left_last), _Right_current(right), _Right_last(right_last)
+        {}
+
+        _NODISCARD inline value_type operator*() const noexcept {
+            return { *_Left_current, *_Right_current };
+        }
+        inline iterator& operator++() noexcept {
+            ++_Left_current;
+            ++_Right_current;
+            return *this;
+        }
+        inline void operator++(int) noexcept {
+            ++*this;
+        }
+        _NODISCARD inline bool operator==(std::default_sentinel_t) const noexcept {
+            return _Left_current == _Left_last || _Right_current == _Right_last;
+        }
+    };
+
+    template <class A, class B>
+    inline ZipView(A&& left, B&& right) noexcept : _Left(std::forward<A>(left)), _Right(std::forward<B>(right)) {}
+
+    _NODISCARD inline iterator begin() noexcept {
+        return iterator(std::begin(_Left.get()), std::end(_Left.get()), std::begin(_Right.get()), std::end(_Right.get()));
+    }
+    _NODISCARD inline std::default_sentinel_t end() noexcept {
+        return {};
+    }
+};
+
+// Consecutive runs of `size` elements, the last one may be shorter.
+template <class R>
+class ChunkView {
+private:
+    _DETAIL _Range_holder<R> _Range;
+    size_t _Size;
+public:
+    class iterator {
+    private:
+        _DETAIL _Range_iterator<R> _Current;
+        _DETAIL _Range_sentinel<R> _Last;
+        size_t _Size{ 1 };
+    public:
+        using value_type = CountedRange<_DETAIL _Range_iterator<R>, _DETAIL _Range_sentinel<R>>;
+        using difference_type = ptrdiff;
+
+        iterator() noexcept = default;
+        inline iterator(_DETAIL _Range_iterator<R> current, _DETAIL _Range_sentinel<R> last, size_t size) noexcept
+            : _Current(current), _Last(last), _Size(size)
+        {}
+
+        _NODISCARD inline value_type operator*() const noexcept {
+            return value_type(_Current, _Last, _Size);
+        }
+        inline iterator& operator++() noexcept {
+            if constexpr (std::random_access_iterator<_DETAIL _Range_iterator<R>> && std::sized_sentinel_for<_DETAIL _Range_sentinel<R>, _DETAIL _Range_iterator<R>>) {
+                const auto _Left = static_cast<size_t>(_Last - _Current);
+                _Current += static_cast<ptrdiff>(_Left < _Size ? _Left : _Size);
+            }
+            else {
+                for (size_t step = 0; step < _Size && _Current != _Last; ++step)
+                    ++_Current;
+            }
+            return *this;
+        }
+        inline void operator++(int) noexcept {
+            ++*this;
+        }
+        _NODISCARD inline bool operator==(std::default_sentinel_t) const noexcept {
+            return _Current == _Last;
+        }
+    };
+
+    template <class Arg>
+    inline ChunkView(Arg&& range, size_t size) noexcept : _Range(std::forward<Arg>(range)), _Size(size ? size : 1) {}
+
+    _NODISCARD inline iterator begin() noexcept {
+        return iterator(std::begin(_Range.get()), std::end(_Range.get()), _Size);
+    }
+    _NODISCARD inline std::default_sentinel_t end() noexcept {
+        return {};
+    }
+};
+
+/*
+    Lazy range adaptors. None of them allocate, every element is produced as it is iterated.
+    Each one can be called directly or piped:
+
+        for (auto [index, value] : enumerate(vec)) ...
+        for (auto x : vec | filter(is_even) | map(square) | take(10)) ...
+
+    Containers passed as lvalues are referenced and must outlive the view.
+*/
+
+template <class R>
+_NODISCARD inline auto enumerate(R&& range) noexcept {
+    return EnumerateView<R&&>(std::forward<R>(range));
+}
+_NODISCARD inline auto enumerate() noexcept {
+    return _DETAIL _Range_pipe{ [](auto&& range) { return enumerate(std::forward<decltype(range)>(range)); } };
+}
+
+template <class R, class Fn>
+_NODISCARD inline auto map(R&& range, Fn fn) noexcept {
+    return MapView<R&&, Fn>(std::forward<R>(range), std::move(fn));
+}
+template <class Fn>
+_NODISCARD inline auto map(Fn fn) noexcept {
+    return _DETAIL _Range_pipe{ [fn = std::move(fn)](auto&& range) { return map(std::forward<decltype(range)>(range), fn); } };
+}
+
+template <class R, class Pred>
+_NODISCARD inline auto filter(R&& range, Pred predicate) noexcept {
+    return FilterView<R&&, Pred>(std::forward<R>(range), std::move(predicate));
+}
+template <class Pred>
+_NODISCARD inline auto filter(Pred predicate) noexcept {
+    return _DETAIL _Range_pipe{ [predicate = std::move(predicate)](auto&& range) { return filter(std::forward<decltype(range)>(range), predicate); } };
+}
+
+template <class R>
+_NODISCARD inline auto take(R&& range, size_t count) noexcept {
+    return TakeView<R&&>(std::forward<R>(range), count);
+}
+_NODISCARD inline auto take(size_t count) noexcept {
+    return _DETAIL _Range_pipe{ [count](auto&& range) { return take(std::forward<decltype(range)>(range), count); } };
+}
+
+template <class L, class R>
+_NODISCARD inline auto zip(L&& left, R&& right) noexcept {
+    return ZipView<L&&, R&&>(std::forward<L>(left), std::forward<R>(right));
+}
+// `left | zip(right)`, right is referenced when it is an lvalue.
+template <class R>
+_NODISCARD inline auto zip(R&& right) noexcept {
+    return _DETAIL _Range_pipe{ [holder = _DETAIL _Range_holder<R&&>(std::forward<R>(right))](auto&& left) mutable {
+        return ZipView<decltype(left), R&&>(std::forward<decltype(left)>(left), std::forward<R>(holder.get()));
+    } };
+}
+
+template <class R>
+_NODISCARD inline auto chunk(R&& range, size_t size) noexcept {
+    return ChunkView<R&&>(std::forward<R>(range), size);
+}
+_NODISCARD inline auto chunk(size_t size) noexcept {
+    return _DETAIL _Range_pipe{ [size](auto&& range) { return chunk(std::forward<decltype(range)>(range), size); } };
+}
+
+_STD_API_END
+
+#define _STD_RANGES
+#endif
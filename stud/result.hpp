@@ -1,10 +1,12 @@
 
 #ifndef _STD_RESULT
 
+#include <algorithm>
 #include <type_traits>
 #include <variant>
 
 #include "forward.hpp"
+#include "format.hpp"
 
 _STD_UNSTABLE_API_BEGIN
 
@@ -158,5 +160,46 @@ T force_unwrap(R* res) {
 
 _STD_API_END
 
+namespace std {
+
+/// <summary>
+/// "Ok(value)" or "Err(error)". The format spec applies to the value, errors always use
+/// their default format. Result&lt;placeholder, E&gt; prints a bare "Ok".
+/// </summary>
+template <class T, class E>
+    requires (std::is_same_v<T, stud::placeholder> || stud::__detail::_Formattable_element<T>) && stud::__detail::_Formattable_element<E>
+struct formatter<stud::Result<T, E>, char> {
+private:
+    static constexpr bool _Has_value = !std::is_same_v<T, stud::placeholder>;
+
+    std::conditional_t<_Has_value, stud::__detail::_Wrapper_formatter<T>, stud::placeholder> _Value;
+    stud::__detail::_Wrapper_formatter<E> _Error;
+public:
+    template <class ParseContext>
+    constexpr auto parse(ParseContext& ctx) {
+        std::format_parse_context _Default{ std::string_view{} };
+        _Error.parse(_Default);
+        if constexpr (_Has_value)
+            return _Value.parse(ctx);
+        else
+            return ctx.begin();
+    }
+
+    template <class FormatContext>
+    auto format(const stud::Result<T, E>& result, FormatContext& ctx) const {
+        if (result.is_err())
+            return _Error._Format("Err", result.view_err(), ctx);
+        if constexpr (_Has_value) {
+            return _Value._Format("Ok", result.view(), ctx);
+        }
+        else {
+            constexpr std::string_view _Ok = "Ok";
+            return std::copy(_Ok.begin(), _Ok.end(), ctx.out());
+        }
+    }
+};
+
+} // namespace std
+
 #define _STD_RESULT
 #endif
\ No newline at end of file
@@ -0,0 +1,218 @@
+
+#ifndef _STD_SIMD
+
+#include <bit>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define _STD_SIMD_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define _STD_SIMD_SSE2 1
+#endif
+
+#include "forward.hpp"
+#include "stddef.hpp"
+
+_STD_DETAIL_API
+
+/// <summary>
+/// Element types the kernels below handle: integers, enums (std::byte included) and
+/// float/double, compared by value. Floats keep their == semantics, NaN never matches
+/// and -0.0 matches 0.0.
+/// </summary>
+template <class T>
+concept _Simd_element = (std::is_integral_v<T> || std::is_enum_v<T> || std::is_same_v<T, float> || std::is_same_v<T, double>)
+    && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+// The unsigned integer with the bit pattern of T.
+template <class T>
+using _Simd_bits = std::conditional_t<sizeof(T) == 1, uint8,
+    std::conditional_t<sizeof(T) == 2, uint16,
+    std::conditional_t<sizeof(T) == 4, uint32, uint64>>>;
+
+template <class T>
+_NODISCARD _STD_INLINE _Simd_bits<T> _Simd_as_bits(T value) noexcept {
+    _Simd_bits<T> _Bits;
+    std::memcpy(&_Bits, &value, sizeof(T));
+    return _Bits;
+}
+
+#if defined(_STD_SIMD_SSE2)
+struct _Simd_sse2 {
+    using _Register = __m128i;
+    static constexpr size_t _Width = 16;
+
+    _NODISCARD static inline _Register _Load(const void* address) noexcept {
+        return _mm_loadu_si128(static_cast<const __m128i*>(address));
+    }
+    static inline void _Store(void* address, _Register value) noexcept {
+        _mm_storeu_si128(static_cast<__m128i*>(address), value);
+    }
+
+    template <class T>
+    _NODISCARD static inline _Register _Broadcast(T value) noexcept {
+        const auto _Bits = _Simd_as_bits(value);
+        if constexpr (sizeof(T) == 1) return _mm_set1_epi8(static_cast<char>(_Bits));
+        else if constexpr (sizeof(T) == 2) return _mm_set1_epi16(static_cast<short>(_Bits));
+        else if constexpr (sizeof(T) == 4) return _mm_set1_epi32(static_cast<int>(_Bits));
+        else return _mm_set1_epi64x(static_cast<long long>(_Bits));
+    }
+
+    // One bit per byte, set for every byte of every lane that compares equal.
+    template <class T>
+    _NODISCARD static inline uint32 _Match(_Register left, _Register right) noexcept {
+        _Register _Equal;
+        if constexpr (std::is_same_v<T, float>)
+            _Equal = _mm_castps_si128(_mm_cmpeq_ps(_mm_castsi128_ps(left), _mm_castsi128_ps(right)));
+        else if constexpr (std::is_same_v<T, double>)
+            _Equal = _mm_castpd_si128(_mm_cmpeq_pd(_mm_castsi128_pd(left), _mm_castsi128_pd(right)));
+        else if constexpr (sizeof(T) == 1)
+            _Equal = _mm_cmpeq_epi8(left, right);
+        else if constexpr (sizeof(T) == 2)
+            _Equal = _mm_cmpeq_epi16(left, right);
+        else if constexpr (sizeof(T) == 4)
+            _Equal = _mm_cmpeq_epi32(left, right);
+        else {
+            // no 64-bit compare before SSE4.1: both 32-bit halves have to match.
+            const _Register _Halves = _mm_cmpeq_epi32(left, right);
+            _Equal = _mm_and_si128(_Halves, _mm_shuffle_epi32(_Halves, _MM_SHUFFLE(2, 3, 0, 1)));
+        }
+        return static_cast<uint32>(_mm_movemask_epi8(_Equal));
+    }
+};
+#endif
+
+#if defined(_STD_SIMD_AVX2)
+struct _Simd_avx2 {
+    using _Register = __m256i;
+    static constexpr size_t _Width = 32;
+
+    _NODISCARD static inline _Register _Load(const void* address) noexcept {
+        return _mm256_loadu_si256(static_cast<const __m256i*>(address));
+    }
+    static inline void _Store(void* address, _Register value) noexcept {
+        _mm256_storeu_si256(static_cast<__m256i*>(address), value);
+    }
+
+    template <class T>
+    _NODISCARD static inline _Register _Broadcast(T value) noexcept {
+        const auto _Bits = _Simd_as_bits(value);
+        if constexpr (sizeof(T) == 1) return _mm256_set1_epi8(static_cast<char>(_Bits));
+        else if constexpr (sizeof(T) == 2) return _mm256_set1_epi16(static_cast<short>(_Bits));
+        else if constexpr (sizeof(T) == 4) return _mm256_set1_epi32(static_cast<int>(_Bits));
+        else return _mm256_set1_epi64x(static_cast<long long>(_Bits));
+    }
+
+    template <class T>
+    _NODISCARD static inline uint32 _Match(_Register left, _Register right) noexcept {
+        _Register _Equal;
+        if constexpr (std::is_same_v<T, float>)
+            _Equal = _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(left), _mm256_castsi256_ps(right), _CMP_EQ_OQ));
+        else if constexpr (std::is_same_v<T, double>)
+            _Equal = _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(left), _mm256_castsi256_pd(right), _CMP_EQ_OQ));
+        else if constexpr (sizeof(T) == 1)
+            _Equal = _mm256_cmpeq_epi8(left, right);
+        else if constexpr (sizeof(T) == 2)
+            _Equal = _mm256_cmpeq_epi16(left, right);
+        else if constexpr (sizeof(T) == 4)
+            _Equal = _mm256_cmpeq_epi32(left, right);
+        else
+            _Equal = _mm256_cmpeq_epi64(left, right);
+        return static_cast<uint32>(_mm256_movemask_epi8(_Equal));
+    }
+};
+#endif
+
+// The widest instruction set the build targets. Without one only the scalar loops remain.
+#if defined(_STD_SIMD_AVX2)
+using _Simd_isa = _Simd_avx2;
+#elif defined(_STD_SIMD_SSE2)
+using _Simd_isa = _Simd_sse2;
+#endif
+
+/// <summary>
+/// Index of the first element equal to `value`, or `count`.
+/// </summary>
+template <_Simd_element T>
+_NODISCARD _STD_INLINE size_t _Simd_find(const T* data, size_t count, T value) noexcept {
+    size_t _Index = 0;
+#if defined(_STD_SIMD_AVX2) || defined(_STD_SIMD_SSE2)
+    using _Isa = _Simd_isa;
+    constexpr size_t _Lanes = _Isa::_Width / sizeof(T);
+    const auto _Needle = _Isa::_Broadcast(value);
+    for (; _Index + _Lanes <= count; _Index += _Lanes) {
+        const uint32 _Mask = _Isa::template _Match<T>(_Isa::_Load(data + _Index), _Needle);
+        if (_Mask != 0)
+            return _Index + static_cast<size_t>(std::countr_zero(_Mask)) / sizeof(T);
+    }
+#endif
+    for (; _Index < count; ++_Index) {
+        if (data[_Index] == value)
+            return _Index;
+    }
+    return count;
+}
+
+/// <summary>
+/// How many elements equal `value`.
+/// </summary>
+template <_Simd_element T>
+_NODISCARD _STD_INLINE size_t _Simd_count(const T* data, size_t count, T value) noexcept {
+    size_t _Index = 0;
+    size_t _Matches = 0;
+#if defined(_STD_SIMD_AVX2) || defined(_STD_SIMD_SSE2)
+    using _Isa = _Simd_isa;
+    constexpr size_t _Lanes = _Isa::_Width / sizeof(T);
+    const auto _Needle = _Isa::_Broadcast(value);
+    for (; _Index + _Lanes <= count; _Index += _Lanes)
+        _Matches += static_cast<size_t>(std::popcount(_Isa::template _Match<T>(_Isa::_Load(data + _Index), _Needle))) / sizeof(T);
+#endif
+    for (; _Index < count; ++_Index)
+        _Matches += data[_Index] == value ? 1 : 0;
+    return _Matches;
+}
+
+/// <summary>
+/// Element-wise ==, so arrays holding NaN are never equal.
+/// </summary>
+template <_Simd_element T>
+_NODISCARD _STD_INLINE bool _Simd_equal(const T* left, const T* right, size_t count) noexcept {
+    size_t _Index = 0;
+#if defined(_STD_SIMD_AVX2) || defined(_STD_SIMD_SSE2)
+    using _Isa = _Simd_isa;
+    constexpr size_t _Lanes = _Isa::_Width / sizeof(T);
+    constexpr uint32 _All = static_cast<uint32>((uint64{ 1 } << _Isa::_Width) - 1);
+    for (; _Index + _Lanes <= count; _Index += _Lanes) {
+        if (_Isa::template _Match<T>(_Isa::_Load(left + _Index), _Isa::_Load(right + _Index)) != _All)
+            return false;
+    }
+#endif
+    for (; _Index < count; ++_Index) {
+        if (!(left[_Index] == right[_Index]))
+            return false;
+    }
+    return true;
+}
+
+template <_Simd_element T>
+_STD_INLINE void _Simd_fill(T* data, size_t count, T value) noexcept {
+    size_t _Index = 0;
+#if defined(_STD_SIMD_AVX2) || defined(_STD_SIMD_SSE2)
+    using _Isa = _Simd_isa;
+    constexpr size_t _Lanes = _Isa::_Width / sizeof(T);
+    const auto _Pattern = _Isa::_Broadcast(value);
+    for (; _Index + _Lanes <= count; _Index += _Lanes)
+        _Isa::_Store(data + _Index, _Pattern);
+#endif
+    for (; _Index < count; ++_Index)
+        data[_Index] = value;
+}
+
+_STD_API_END
+
+#define _STD_SIMD
+#endif
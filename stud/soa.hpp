@@ -0,0 +1,344 @@
+
+#ifndef _STD_SOA
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "forward.hpp"
+#include "stddef.hpp"
+#include "panic.hpp"
+
+_STD_DETAIL_API
+
+// Every column starts on a cache line, so a kernel over one field can use aligned loads.
+inline constexpr size_t _Soa_alignment = 64;
+
+template <class F>
+_NODISCARD _STD_INLINE F* _Soa_allocate(size_t count) noexcept {
+    constexpr size_t _Alignment = alignof(F) > _Soa_alignment ? alignof(F) : _Soa_alignment;
+    return static_cast<F*>(::operator new(sizeof(F) * count, std::align_val_t{ _Alignment }, std::nothrow));
+}
+
+template <class F>
+_STD_INLINE void _Soa_deallocate(F* column) noexcept {
+    constexpr size_t _Alignment = alignof(F) > _Soa_alignment ? alignof(F) : _Soa_alignment;
+    ::operator delete(column, std::align_val_t{ _Alignment });
+}
+
+_STD_API_END
+
+_STD_API_BEGIN
+
+/// <summary>
+/// One row of a SoaVector: a reference to the element at the same index in every column.
+/// Fields are read with get&lt;I&gt;() or structured bindings (auto [x, y] = soa[i]), which
+/// bind to the columns themselves. Assigning a std::tuple writes every field.
+/// </summary>
+template <class... Fields>
+class SoaRef {
+private:
+    std::tuple<Fields&...> _Fields;
+public:
+    _STD_API explicit SoaRef(Fields&... fields) noexcept
+        : _Fields(fields...)
+    {}
+
+    template <size_t I>
+    _NODISCARD _STD_API auto& get() const noexcept {
+        return std::get<I>(_Fields);
+    }
+
+    _STD_API const SoaRef& operator=(const std::tuple<std::remove_const_t<Fields>...>& values) const noexcept {
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            ((std::get<I>(_Fields) = std::get<I>(values)), ...);
+        }(std::index_sequence_for<Fields...>{});
+        return *this;
+    }
+
+    // A copy of the row.
+    _NODISCARD _STD_API std::tuple<std::remove_const_t<Fields>...> value() const noexcept {
+        return std::tuple<std::remove_const_t<Fields>...>(_Fields);
+    }
+
+    template <size_t I>
+    _NODISCARD friend _STD_API auto& get(const SoaRef& row) noexcept {
+        return row.get<I>();
+    }
+};
+
+/// <summary>
+/// A growable table stored as a structure of arrays: each field lives in its own column,
+/// aligned to a cache line. A loop that reads one field of every row streams through
+/// only that column instead of dragging whole records through the cache.
+///
+/// column&lt;I&gt;() hands out a field as a std::span for vectorized kernels. operator[]
+/// and iteration yield SoaRef rows for code that wants record-at-a-time access. Growth
+/// moves each column like Vector does, so column spans and rows are invalidated by it.
+/// </summary>
+template <class... Fields>
+class SoaVector {
+    static_assert(sizeof...(Fields) > 0, "SoaVector needs at least one field.");
+public:
+    using reference = SoaRef<Fields...>;
+    using const_reference = SoaRef<const Fields...>;
+
+    static constexpr size_t field_count = sizeof...(Fields);
+
+    template <size_t I>
+    using field_type = std::tuple_element_t<I, std::tuple<Fields...>>;
+private:
+    template <class Ref, class Owner>
+    class _Row_iterator {
+    private:
+        Owner* _Owner{ nullptr };
+        size_t _Index{ 0 };
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::tuple<Fields...>;
+        using difference_type = ptrdiff;
+        using reference = Ref;
+
+        _Row_iterator() noexcept = default;
+        _STD_API _Row_iterator(Owner* owner, size_t index) noexcept
+            : _Owner(owner), _Index(index)
+        {}
+
+        _NODISCARD _STD_API Ref operator*() const noexcept {
+            return (*_Owner)[_Index];
+        }
+        _STD_API _Row_iterator& operator++() noexcept {
+            ++_Index;
+            return *this;
+        }
+        _STD_API _Row_iterator operator++(int) noexcept {
+            auto _Old = *this;
+            ++_Index;
+            return _Old;
+        }
+        _NODISCARD friend _STD_API bool operator==(const _Row_iterator& left, const _Row_iterator& right) noexcept {
+            return left._Index == right._Index;
+        }
+    };
+
+    std::tuple<Fields*...> _Columns{};
+    size_t _Size{ 0 };
+    size_t _Capacity{ 0 };
+public:
+    using iterator = _Row_iterator<reference, SoaVector>;
+    using const_iterator = _Row_iterator<const_reference, const SoaVector>;
+
+    SoaVector() noexcept = default;
+    inline SoaVector(const SoaVector& other) noexcept {
+        reserve(other._Size);
+        _For_columns([&](auto* column, auto index) {
+            const auto* _Source = std::get<decltype(index)::value>(other._Columns);
+            for (size_t row = 0; row < other._Size; ++row)
+                ::new (static_cast<void*>(column + row)) std::remove_pointer_t<decltype(column)>(_Source[row]);
+        });
+        _Size = other._Size;
+    }
+    inline SoaVector(SoaVector&& other) noexcept {
+        swap(other);
+    }
+    inline SoaVector& operator=(const SoaVector& other) noexcept {
+        if (this != &other) {
+            SoaVector _Copy(other);
+            swap(_Copy);
+        }
+        return *this;
+    }
+    inline SoaVector& operator=(SoaVector&& other) noexcept {
+        if (this != &other) {
+            SoaVector _Moved(std::move(other));
+            swap(_Moved);
+        }
+        return *this;
+    }
+    inline ~SoaVector() noexcept {
+        clear();
+        _For_columns([](auto* column, auto) {
+            if (column)
+                _DETAIL _Soa_deallocate(column);
+        });
+    }
+
+    inline reference push_back(Fields... fields) noexcept {
+        return emplace_back(std::move(fields)...);
+    }
+    inline reference push_back(std::tuple<Fields...> row) noexcept {
+        return std::apply([&](auto&... fields) { return emplace_back(std::move(fields)...); }, row);
+    }
+
+    // One constructor argument per field, in order.
+    template <class... Args>
+    inline reference emplace_back(Args&&... args) noexcept {
+        static_assert(sizeof...(Args) == sizeof...(Fields), "SoaVector::emplace_back() takes one argument per field.");
+        if (_Size == _Capacity) {
+            // the arguments may refer to rows that are about to move, take them out first.
+            std::tuple<Fields...> _Row(std::forward<Args>(args)...);
+            reserve(_Capacity == 0 ? 8 : _Capacity * 2);
+            return push_back(std::move(_Row));
+        }
+        _Construct_row(_Size, std::index_sequence_for<Fields...>{}, std::forward<Args>(args)...);
+        return (*this)[_Size++];
+    }
+
+    inline void pop_back() noexcept {
+        panic(IF(_Size == 0), "cannot pop_back an empty SoaVector.");
+        --_Size;
+        _For_columns([&](auto* column, auto) {
+            std::destroy_at(column + _Size);
+        });
+    }
+
+    inline void reserve(size_t capacity) noexcept {
+        if (capacity <= _Capacity)
+            return;
+        _For_columns([&](auto* column, auto index) {
+            using _Field = std::remove_pointer_t<decltype(column)>;
+            _Field* _New = _DETAIL _Soa_allocate<_Field>(capacity);
+            panic(IF(_New == nullptr), "SoaVector: failed to allocate a column of {} elements.", capacity);
+            if (column) {
+                if constexpr (std::is_trivially_copyable_v<_Field>) {
+                    std::memcpy(static_cast<void*>(_New), column, sizeof(_Field) * _Size);
+                }
+                else {
+                    std::uninitialized_move(column, column + _Size, _New);
+                    std::destroy(column, column + _Size);
+                }
+                _DETAIL _Soa_deallocate(column);
+            }
+            std::get<decltype(index)::value>(_Columns) = _New;
+        });
+        _Capacity = capacity;
+    }
+
+    // New rows are value initialized.
+    inline void resize(size_t size) noexcept {
+        while (_Size > size)
+            pop_back();
+        reserve(size);
+        for (; _Size < size; ++_Size) {
+            _For_columns([&](auto* column, auto) {
+                ::new (static_cast<void*>(column + _Size)) std::remove_pointer_t<decltype(column)>();
+            });
+        }
+    }
+
+    inline void clear() noexcept {
+        _For_columns([&](auto* column, auto) {
+            if (column)
+                std::destroy(column, column + _Size);
+        });
+        _Size = 0;
+    }
+
+    /// <summary>
+    /// Field I of every row. The span starts on a 64 byte boundary.
+    /// </summary>
+    template <size_t I>
+    _NODISCARD inline std::span<field_type<I>> column() noexcept {
+        return { data<I>(), _Size };
+    }
+    template <size_t I>
+    _NODISCARD inline std::span<const field_type<I>> column() const noexcept {
+        return { data<I>(), _Size };
+    }
+
+    template <size_t I>
+    _NODISCARD inline field_type<I>* data() noexcept {
+        auto* _Column = std::get<I>(_Columns);
+        return _Column ? std::assume_aligned<_DETAIL _Soa_alignment>(_Column) : nullptr;
+    }
+    template <size_t I>
+    _NODISCARD inline const field_type<I>* data() const noexcept {
+        const auto* _Column = std::get<I>(_Columns);
+        return _Column ? std::assume_aligned<_DETAIL _Soa_alignment>(_Column) : nullptr;
+    }
+
+    _NODISCARD inline reference operator[](size_t index) noexcept {
+        return std::apply([&](auto*... columns) { return reference(columns[index]...); }, _Columns);
+    }
+    _NODISCARD inline const_reference operator[](size_t index) const noexcept {
+        return std::apply([&](auto*... columns) { return const_reference(columns[index]...); }, _Columns);
+    }
+    _NODISCARD inline reference at(size_t index) noexcept {
+        panic(IF(index >= _Size), "SoaVector::at(): index {} is out of range for size {}.", index, _Size);
+        return (*this)[index];
+    }
+    _NODISCARD inline const_reference at(size_t index) const noexcept {
+        panic(IF(index >= _Size), "SoaVector::at(): index {} is out of range for size {}.", index, _Size);
+        return (*this)[index];
+    }
+
+    _NODISCARD inline size_t size() const noexcept {
+        return _Size;
+    }
+    _NODISCARD inline size_t capacity() const noexcept {
+        return _Capacity;
+    }
+    _NODISCARD inline bool empty() const noexcept {
+        return _Size == 0;
+    }
+
+    _NODISCARD inline iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+    _NODISCARD inline iterator end() noexcept {
+        return iterator(this, _Size);
+    }
+    _NODISCARD inline const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+    _NODISCARD inline const_iterator end() const noexcept {
+        return const_iterator(this, _Size);
+    }
+
+    inline void swap(SoaVector& other) noexcept {
+        std::swap(_Columns, other._Columns);
+        std::swap(_Size, other._Size);
+        std::swap(_Capacity, other._Capacity);
+    }
+    friend inline void swap(SoaVector& left, SoaVector& right) noexcept {
+        left.swap(right);
+    }
+
+private:
+    // fn(column pointer, std::integral_constant<size_t, I>) for every column.
+    template <class Fn>
+    inline void _For_columns(Fn&& fn) noexcept {
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            (fn(std::get<I>(_Columns), std::integral_constant<size_t, I>{}), ...);
+        }(std::index_sequence_for<Fields...>{});
+    }
+
+    template <size_t... I, class... Args>
+    inline void _Construct_row(size_t row, std::index_sequence<I...>, Args&&... args) noexcept {
+        (::new (static_cast<void*>(std::get<I>(_Columns) + row)) Fields(std::forward<Args>(args)), ...);
+    }
+};
+
+_STD_API_END
+
+namespace std {
+
+template <class... Fields>
+struct tuple_size<stud::SoaRef<Fields...>>
+    : integral_constant<size_t, sizeof...(Fields)> {};
+
+template <size_t I, class... Fields>
+struct tuple_element<I, stud::SoaRef<Fields...>> {
+    using type = tuple_element_t<I, tuple<Fields...>>&;
+};
+
+} // namespace std
+
+#define _STD_SOA
+#endif
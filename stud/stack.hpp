@@ -3,10 +3,17 @@
 
 #include <initializer_list>
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
 #include <iterator>
+#include <new>
 
 #include "forward.hpp"
+#include "stddef.hpp"
 #include "panic.hpp"
+#include "option.hpp"
+#include "format.hpp"
 
 _STD_API_BEGIN
 
@@ -16,6 +23,7 @@ protected:
     T _stack[N];
     size_t _pos{ 0 };
 public:
+    using value_type = T;
 
     // we do not initialize anything in the stack itself.
     _STD_API StaticStack() noexcept = default;
@@ -30,16 +38,16 @@ public:
     {}
 
     _STD_API T* push(T&& value) noexcept {
-        panic(IF(++_pos > N), "static_stack: limit exceeded");
+        panic(IF(_pos >= N), "static_stack: limit exceeded");
         _stack[_pos] = std::move(value);
-        return &_stack[_pos];
+        return &_stack[_pos++];
     }
 
     template<typename... Ts>
     _STD_API T* emplace(Ts&&... args) _STD_NOEXCEPT(T(std::forward<Ts>(args)...)) {
-        panic(IF(++_pos > N), "static_stack: limit exceeded.");
+        panic(IF(_pos >= N), "static_stack: limit exceeded.");
         _stack[_pos] = T(std::forward<Ts>(args)...);
-        return &_stack[_pos];
+        return &_stack[_pos++];
     }
 
     _NODISCARD _STD_API T&& pop() noexcept {
@@ -49,15 +57,15 @@ public:
 
     _NODISCARD _STD_API T* peek() noexcept {
         panic(IF(_pos == 0), "cannot peek into an empty stack.");
-        return &_stack[_pos];
+        return &_stack[_pos - 1];
     }
     _NODISCARD _STD_API const T* peek() const noexcept {
         panic(IF(_pos == 0), "cannot peek into an empty stack.");
-        return &_stack[_pos];
+        return &_stack[_pos - 1];
     }
 
     _NODISCARD _STD_API T* data() noexcept {
-        return &_stack;
+        return _stack;
     }
 
     _NODISCARD _STD_API T* front() noexcept {
@@ -74,15 +82,344 @@ public:
         return _stack + N;
     }
 
+    // The elements currently on the stack, bottom first.
+    _NODISCARD _STD_API T* begin() noexcept {
+        return _stack;
+    }
+    _NODISCARD _STD_API T* end() noexcept {
+        return _stack + _pos;
+    }
+    _NODISCARD _STD_API const T* begin() const noexcept {
+        return _stack;
+    }
+    _NODISCARD _STD_API const T* end() const noexcept {
+        return _stack + _pos;
+    }
+
     _NODISCARD _STD_API size_t size() const noexcept {
-        return N;
+        return _pos;
     }
     _NODISCARD _STD_API size_t capacity() const noexcept {
         return N;
     }
 };
 
+/// <summary>
+/// An unbounded stack that grows in chunks instead of reallocating: chunk k holds
+/// (16 << k) elements and lives until the stack shrinks well below it, so pushes never
+/// move existing elements and pointers returned by push() stay valid until that element
+/// is popped. One spare chunk is kept past the top so pushing and popping across a chunk
+/// boundary does not allocate every time.
+/// </summary>
+template <class T>
+class Stack {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "Stack chunks come from malloc, over-aligned types are not supported.");
+
+    static constexpr size_t _First_chunk = 16;
+    // 16 << 47 elements, more than any address space.
+    static constexpr size_t _Max_chunks = 48;
+
+    T* _Chunks[_Max_chunks]{};
+    size_t _Allocated{ 0 };
+    // the chunk holding the top element, and how many elements it holds.
+    size_t _Chunk{ 0 };
+    size_t _Used{ 0 };
+    size_t _Size{ 0 };
+public:
+    using value_type = T;
+
+    _STD_MAKE_NONCOPYABLE(Stack);
+
+    Stack() noexcept = default;
+    inline Stack(std::initializer_list<T> init) noexcept {
+        for (const auto& element : init)
+            push(element);
+    }
+    inline Stack(Stack&& other) noexcept {
+        swap(other);
+    }
+    inline Stack& operator=(Stack&& other) noexcept {
+        if (this != &other) {
+            Stack _Moved(std::move(other));
+            swap(_Moved);
+        }
+        return *this;
+    }
+    inline ~Stack() noexcept {
+        clear();
+        _Release_from(0);
+    }
+
+    inline T* push(T&& value) noexcept {
+        return emplace(std::move(value));
+    }
+    inline T* push(const T& value) noexcept {
+        return emplace(value);
+    }
+
+    template <typename... Ts>
+    inline T* emplace(Ts&&... args) noexcept {
+        if (_Used == _Chunk_capacity(_Chunk)) {
+            ++_Chunk;
+            _Used = 0;
+        }
+        if (_Chunk == _Allocated) {
+            panic(IF(_Allocated == _Max_chunks), "Stack: limit exceeded.");
+            auto* _New = static_cast<T*>(::malloc(sizeof(T) * _Chunk_capacity(_Allocated)));
+            panic(IF(_New == nullptr), "Stack: failed to allocate a chunk of {} elements.", _Chunk_capacity(_Allocated));
+            _Chunks[_Allocated++] = _New;
+        }
+        T* _Slot = ::new (static_cast<void*>(_Chunks[_Chunk] + _Used)) T(std::forward<Ts>(args)...);
+        ++_Used;
+        ++_Size;
+        return _Slot;
+    }
+
+    _NODISCARD inline T pop() noexcept {
+        panic(IF(_Size == 0), "cannot pop from an empty stack.");
+        T* _Slot = _Chunks[_Chunk] + (_Used - 1);
+        T _Value = std::move(*_Slot);
+        _Slot->~T();
+        _Step_back();
+        return _Value;
+    }
+
+    _NODISCARD inline T* peek() noexcept {
+        panic(IF(_Size == 0), "cannot peek into an empty stack.");
+        return _Chunks[_Chunk] + (_Used - 1);
+    }
+    _NODISCARD inline const T* peek() const noexcept {
+        panic(IF(_Size == 0), "cannot peek into an empty stack.");
+        return _Chunks[_Chunk] + (_Used - 1);
+    }
+
+    // Destroys every element but keeps the chunks for reuse.
+    inline void clear() noexcept {
+        while (_Size != 0) {
+            _Chunks[_Chunk][_Used - 1].~T();
+            _Step_back();
+        }
+    }
+
+    // Calls fn(element) for every element, bottom first.
+    template <class Fn>
+    inline void for_each(Fn&& fn) {
+        _For_each(*this, fn);
+    }
+    template <class Fn>
+    inline void for_each(Fn&& fn) const {
+        _For_each(*this, fn);
+    }
+
+    _NODISCARD inline size_t size() const noexcept {
+        return _Size;
+    }
+    _NODISCARD inline bool empty() const noexcept {
+        return _Size == 0;
+    }
+    _NODISCARD inline size_t capacity() const noexcept {
+        return _First_chunk * ((size_t{ 1 } << _Allocated) - 1);
+    }
+
+    inline void swap(Stack& other) noexcept {
+        std::swap(_Chunks, other._Chunks);
+        std::swap(_Allocated, other._Allocated);
+        std::swap(_Chunk, other._Chunk);
+        std::swap(_Used, other._Used);
+        std::swap(_Size, other._Size);
+    }
+    friend inline void swap(Stack& left, Stack& right) noexcept {
+        left.swap(right);
+    }
+
+private:
+    _NODISCARD static constexpr size_t _Chunk_capacity(size_t chunk) noexcept {
+        return _First_chunk << chunk;
+    }
+
+    // after removing the top: keep _Used > 0 while anything is left, and drop chunks
+    // more than one past the top.
+    inline void _Step_back() noexcept {
+        --_Size;
+        if (--_Used == 0 && _Chunk != 0) {
+            --_Chunk;
+            _Used = _Chunk_capacity(_Chunk);
+            _Release_from(_Chunk + 2);
+        }
+    }
+
+    inline void _Release_from(size_t first) noexcept {
+        while (_Allocated > first)
+            ::free(_Chunks[--_Allocated]);
+    }
+
+    template <class Self, class Fn>
+    static inline void _For_each(Self& self, Fn& fn) {
+        for (size_t chunk = 0; chunk <= self._Chunk && self._Size != 0; ++chunk) {
+            const size_t _Count = chunk == self._Chunk ? self._Used : _Chunk_capacity(chunk);
+            for (size_t index = 0; index < _Count; ++index)
+                fn(self._Chunks[chunk][index]);
+        }
+    }
+};
+
+/// <summary>
+/// A lock-free (Treiber) stack, safe to push and pop from any number of threads.
+///
+/// The head is a pointer packed with a counter that changes on every push and pop, so a
+/// compare-exchange cannot succeed against a head that was popped and pushed back in the
+/// meantime (the ABA problem). Popped nodes go onto an internal free list rather than back
+/// to the allocator, which keeps every node readable by a thread that is still racing on
+/// it, and makes the stack itself a cheap free list: reserve() up front and steady state
+/// pushes and pops never allocate. Nodes are only freed by the destructor.
+///
+/// The counter gets the bits above a 48-bit user space pointer (16 on 64-bit targets),
+/// so a thread would have to stall across 65536 operations on the same head to be fooled.
+/// </summary>
+template <class T>
+class AtomicStack {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "AtomicStack nodes come from malloc, over-aligned types are not supported.");
+
+    struct _Node {
+        alignas(T) unsigned char _Storage[sizeof(T)];
+        std::atomic<_Node*> _Next{ nullptr };
+        // every node ever allocated, for the destructor.
+        _Node* _Owned_next{ nullptr };
+
+        _NODISCARD inline T* _Value() noexcept {
+            return std::launder(reinterpret_cast<T*>(_Storage));
+        }
+    };
+
+    class _Tagged_head {
+        static constexpr uint32 _Pointer_bits = sizeof(void*) == 8 ? 48 : 32;
+        static constexpr uint64 _Pointer_mask = (uint64{ 1 } << _Pointer_bits) - 1;
+
+        std::atomic<uint64> _Word{ 0 };
+
+        _NODISCARD static inline _Node* _Pointer(uint64 word) noexcept {
+            return reinterpret_cast<_Node*>(static_cast<uintptr>(word & _Pointer_mask));
+        }
+        _NODISCARD static inline uint64 _Next_word(uint64 word, _Node* node) noexcept {
+            const uint64 _Tag = (word >> _Pointer_bits) + 1;
+            return (static_cast<uint64>(reinterpret_cast<uintptr>(node)) & _Pointer_mask) | (_Tag << _Pointer_bits);
+        }
+    public:
+        inline void push(_Node* node) noexcept {
+            uint64 _Old = _Word.load(std::memory_order_relaxed);
+            do {
+                node->_Next.store(_Pointer(_Old), std::memory_order_relaxed);
+            } while (!_Word.compare_exchange_weak(_Old, _Next_word(_Old, node), std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        _NODISCARD inline _Node* pop() noexcept {
+            uint64 _Old = _Word.load(std::memory_order_acquire);
+            _Node* _Top;
+            do {
+                _Top = _Pointer(_Old);
+                if (_Top == nullptr)
+                    return nullptr;
+                // _Top may be popped and reused before this load, the tag then fails the exchange.
+            } while (!_Word.compare_exchange_weak(_Old, _Next_word(_Old, _Top->_Next.load(std::memory_order_relaxed)), std::memory_order_acquire, std::memory_order_acquire));
+            return _Top;
+        }
+
+        _NODISCARD inline bool empty() const noexcept {
+            return _Pointer(_Word.load(std::memory_order_relaxed)) == nullptr;
+        }
+    };
+
+    _Tagged_head _Top;
+    _Tagged_head _Free;
+    std::atomic<_Node*> _Owned{ nullptr };
+public:
+    using value_type = T;
+
+    _STD_MAKE_NONCOPYABLE(AtomicStack);
+    _STD_MAKE_NONMOVEABLE(AtomicStack);
+
+    AtomicStack() noexcept = default;
+    inline ~AtomicStack() noexcept {
+        while (auto* _Node_ptr = _Top.pop())
+            _Node_ptr->_Value()->~T();
+        for (auto* _Node_ptr = _Owned.load(std::memory_order_acquire); _Node_ptr != nullptr;) {
+            auto* _Next = _Node_ptr->_Owned_next;
+            _Node_ptr->~_Node();
+            ::free(_Node_ptr);
+            _Node_ptr = _Next;
+        }
+    }
+
+    inline void push(T&& value) noexcept {
+        emplace(std::move(value));
+    }
+    inline void push(const T& value) noexcept {
+        emplace(value);
+    }
+
+    template <typename... Ts>
+    inline void emplace(Ts&&... args) noexcept {
+        auto* _Node_ptr = _Acquire_node();
+        ::new (static_cast<void*>(_Node_ptr->_Storage)) T(std::forward<Ts>(args)...);
+        _Top.push(_Node_ptr);
+    }
+
+    // none when the stack was empty.
+    _NODISCARD inline Option<T> pop() noexcept {
+        auto* _Node_ptr = _Top.pop();
+        if (_Node_ptr == nullptr)
+            return none;
+        T _Value = std::move(*_Node_ptr->_Value());
+        _Node_ptr->_Value()->~T();
+        _Free.push(_Node_ptr);
+        return Option<T>(std::move(_Value));
+    }
+
+    // Allocates nodes for `count` more pushes ahead of time.
+    inline void reserve(size_t count) noexcept {
+        for (size_t index = 0; index < count; ++index)
+            _Free.push(_Allocate_node());
+    }
+
+    // Only a snapshot while other threads are pushing or popping.
+    _NODISCARD inline bool empty() const noexcept {
+        return _Top.empty();
+    }
+
+private:
+    _NODISCARD inline _Node* _Acquire_node() noexcept {
+        if (auto* _Recycled = _Free.pop())
+            return _Recycled;
+        return _Allocate_node();
+    }
+
+    _NODISCARD inline _Node* _Allocate_node() noexcept {
+        void* _Memory = ::malloc(sizeof(_Node));
+        panic(IF(_Memory == nullptr), "AtomicStack: failed to allocate a node.");
+        auto* _Node_ptr = ::new (_Memory) _Node();
+        _Node* _Head = _Owned.load(std::memory_order_relaxed);
+        do {
+            _Node_ptr->_Owned_next = _Head;
+        } while (!_Owned.compare_exchange_weak(_Head, _Node_ptr, std::memory_order_release, std::memory_order_relaxed));
+        return _Node_ptr;
+    }
+};
+
 _STD_API_END
 
+namespace std {
+
+// Bottom of the stack first.
+template <class T, size_t N>
+    requires stud::__detail::_Formattable_element<T>
+struct formatter<stud::StaticStack<T, N>, char> : stud::__detail::_Sequence_formatter<T> {
+    template <class FormatContext>
+    auto format(const stud::StaticStack<T, N>& stack, FormatContext& ctx) const {
+        return this->_Format(stack.begin(), stack.end(), ctx);
+    }
+};
+
+} // namespace std
+
 #define _STD_STACK
 #endif
\ No newline at end of file
@@ -0,0 +1,232 @@
+
+#ifndef _STD_STATIC_MAP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+
+#include "forward.hpp"
+#include "stddef.hpp"
+#include "panic.hpp"
+#include "algorithm.hpp"
+#include "hash.hpp"
+
+_STD_DETAIL_API
+
+/// <summary>
+/// The collision free slot layout behind static_map and static_set ("hash and displace").
+/// Keys are grouped into buckets by the low bits of their hash. Buckets are placed largest
+/// first, each one trying displacements until every key in it lands in a free slot:
+///
+///     slot = ((hash ^ displacement[bucket]) * golden) >> shift
+///
+/// so a lookup is one hash, two table reads and one key compare. Built during constant
+/// evaluation; two keys with the same hash (duplicates) stop the build with a panic.
+/// </summary>
+template <size_t N>
+struct _Perfect_hash_layout {
+    static_assert(N > 0, "a static_map needs at least one entry.");
+
+    // about 80% full, with at least two slots so the shift stays below 64.
+    static constexpr size_t _Slot_count = std::bit_ceil(N + N / 4 + 2);
+    static constexpr size_t _Bucket_count = std::bit_ceil(N / 2 + 1);
+    static constexpr uint32 _Slot_shift = 64 - std::countr_zero(_Slot_count);
+    static constexpr uint32 _Empty = ~uint32{ 0 };
+
+    uint32 _Displacement[_Bucket_count]{};
+    // index of the entry stored in each slot, _Empty when none.
+    uint32 _Slots[_Slot_count]{};
+
+    _NODISCARD static constexpr size_t _Bucket(uint64 hash) noexcept {
+        return static_cast<size_t>(hash & (_Bucket_count - 1));
+    }
+    _NODISCARD static constexpr size_t _Place(uint64 hash, uint32 displacement) noexcept {
+        return static_cast<size_t>(((hash ^ displacement) * 0x9E3779B97F4A7C15ull) >> _Slot_shift);
+    }
+
+    // The entry index that `hash` could be, or _Empty.
+    _NODISCARD constexpr uint32 _Lookup(uint64 hash) const noexcept {
+        return _Slots[_Place(hash, _Displacement[_Bucket(hash)])];
+    }
+
+    constexpr explicit _Perfect_hash_layout(const uint64(&hashes)[N]) noexcept {
+        for (auto& slot : _Slots)
+            slot = _Empty;
+
+        size_t _Sizes[_Bucket_count]{};
+        for (size_t index = 0; index < N; ++index) {
+            for (size_t other = 0; other < index; ++other)
+                panic(IF(hashes[index] == hashes[other]), "static_map: duplicate key (entries {} and {}).", other, index);
+            ++_Sizes[_Bucket(hashes[index])];
+        }
+
+        uint32 _Order[_Bucket_count]{};
+        for (uint32 bucket = 0; bucket < _Bucket_count; ++bucket)
+            _Order[bucket] = bucket;
+        std::sort(_Order, _Order + _Bucket_count, [&](uint32 left, uint32 right) {
+            return _Sizes[left] > _Sizes[right];
+        });
+
+        for (const uint32 bucket : _Order) {
+            if (_Sizes[bucket] == 0)
+                break;
+            uint32 _Members[N]{};
+            size_t _Count = 0;
+            for (uint32 index = 0; index < N; ++index) {
+                if (_Bucket(hashes[index]) == bucket)
+                    _Members[_Count++] = index;
+            }
+
+            for (uint32 displacement = 0;; ++displacement) {
+                panic(IF(displacement == _Empty), "static_map: no displacement places bucket {}.", bucket);
+                size_t _Placed[N]{};
+                bool _Fits = true;
+                for (size_t member = 0; member < _Count && _Fits; ++member) {
+                    _Placed[member] = _Place(hashes[_Members[member]], displacement);
+                    _Fits = _Slots[_Placed[member]] == _Empty;
+                    for (size_t earlier = 0; earlier < member && _Fits; ++earlier)
+                        _Fits = _Placed[earlier] != _Placed[member];
+                }
+                if (!_Fits)
+                    continue;
+                for (size_t member = 0; member < _Count; ++member)
+                    _Slots[_Placed[member]] = _Members[member];
+                _Displacement[bucket] = displacement;
+                break;
+            }
+        }
+    }
+};
+
+template <class K, size_t N, class Hasher, class Source>
+_NODISCARD _STD_API _Perfect_hash_layout<N> _Make_perfect_hash(const Source(&entries)[N], const Hasher& hasher) noexcept {
+    uint64 _Hashes[N]{};
+    for (size_t index = 0; index < N; ++index) {
+        if constexpr (std::is_same_v<Source, K>)
+            _Hashes[index] = hasher(entries[index]);
+        else
+            _Hashes[index] = hasher(entries[index].key);
+    }
+    return _Perfect_hash_layout<N>(_Hashes);
+}
+
+_STD_API_END
+
+_STD_API_BEGIN
+
+/// <summary>
+/// An immutable map built at compile time from a literal list, with a collision free
+/// table so a lookup is one hash and one key compare. Meant for keyword and name tables:
+///
+///     constexpr auto colours = stud::make_static_map&lt;std::string_view, int&gt;({
+///         { "red", 0xFF0000 }, { "green", 0x00FF00 },
+///     });
+///     colours.find("red"); // const int*, nullptr when absent
+///
+/// K and V must be literal types. Lookups with the default hasher take any string-like
+/// type for string keys as is, any other probe is converted to K first.
+/// </summary>
+template <class K, class V, size_t N, class Hasher = DefaultHasher, class KeyEqual = DefaultKeyEqual>
+class static_map {
+public:
+    using entry_type = pair<K, V>;
+private:
+    entry_type _Entries[N];
+    _DETAIL _Perfect_hash_layout<N> _Layout;
+public:
+    constexpr explicit static_map(const entry_type(&entries)[N]) noexcept
+        : _Entries{}, _Layout(_DETAIL _Make_perfect_hash<K>(entries, Hasher{}))
+    {
+        std::copy(entries, entries + N, _Entries);
+    }
+
+    // nullptr when the key is not present.
+    template <class Q>
+    _NODISCARD constexpr const V* find(const Q& key) const noexcept {
+        const _DETAIL _Lookup_key<Hasher, KeyEqual, K, Q>& _Key = key;
+        const uint32 _Index = _Layout._Lookup(Hasher{}(_Key));
+        if (_Index == _Layout._Empty || !KeyEqual{}(_Entries[_Index].key, _Key))
+            return nullptr;
+        return &_Entries[_Index].value;
+    }
+
+    template <class Q>
+    _NODISCARD constexpr bool contains(const Q& key) const noexcept {
+        return find(key) != nullptr;
+    }
+
+    template <class Q>
+    _NODISCARD constexpr const V& at(const Q& key) const noexcept {
+        const V* _Value = find(key);
+        panic(IF(_Value == nullptr), "static_map::at(): key is not present.");
+        return *_Value;
+    }
+
+    // `fallback` when the key is not present.
+    template <class Q>
+    _NODISCARD constexpr const V& get_or(const Q& key, const V& fallback) const noexcept {
+        const V* _Value = find(key);
+        return _Value ? *_Value : fallback;
+    }
+
+    _NODISCARD static constexpr size_t size() noexcept {
+        return N;
+    }
+
+    // The entries, in the order they were given.
+    _NODISCARD constexpr const entry_type* begin() const noexcept {
+        return _Entries;
+    }
+    _NODISCARD constexpr const entry_type* end() const noexcept {
+        return _Entries + N;
+    }
+};
+
+/// <summary>
+/// static_map without values: a compile time keyword set.
+/// </summary>
+template <class K, size_t N, class Hasher = DefaultHasher, class KeyEqual = DefaultKeyEqual>
+class static_set {
+private:
+    K _Keys[N];
+    _DETAIL _Perfect_hash_layout<N> _Layout;
+public:
+    constexpr explicit static_set(const K(&keys)[N]) noexcept
+        : _Keys{}, _Layout(_DETAIL _Make_perfect_hash<K>(keys, Hasher{}))
+    {
+        std::copy(keys, keys + N, _Keys);
+    }
+
+    template <class Q>
+    _NODISCARD constexpr bool contains(const Q& key) const noexcept {
+        const _DETAIL _Lookup_key<Hasher, KeyEqual, K, Q>& _Key = key;
+        const uint32 _Index = _Layout._Lookup(Hasher{}(_Key));
+        return _Index != _Layout._Empty && KeyEqual{}(_Keys[_Index], _Key);
+    }
+
+    _NODISCARD static constexpr size_t size() noexcept {
+        return N;
+    }
+
+    _NODISCARD constexpr const K* begin() const noexcept {
+        return _Keys;
+    }
+    _NODISCARD constexpr const K* end() const noexcept {
+        return _Keys + N;
+    }
+};
+
+template <class K, class V, class Hasher = DefaultHasher, class KeyEqual = DefaultKeyEqual, size_t N>
+_NODISCARD constexpr auto make_static_map(const pair<K, V>(&entries)[N]) noexcept {
+    return static_map<K, V, N, Hasher, KeyEqual>(entries);
+}
+
+template <class K, class Hasher = DefaultHasher, class KeyEqual = DefaultKeyEqual, size_t N>
+_NODISCARD constexpr auto make_static_set(const K(&keys)[N]) noexcept {
+    return static_set<K, N, Hasher, KeyEqual>(keys);
+}
+
+_STD_API_END
+
+#define _STD_STATIC_MAP
+#endif
@@ -11,6 +11,12 @@ _STD_API_BEGIN
 
 using usize = std::size_t;
 
+using int8 = std::int8_t;
+using uint8 = std::uint8_t;
+
+using int16 = std::int16_t;
+using uint16 = std::uint16_t;
+
 using int32 = std::int32_t;
 using uint32 = std::uint32_t;
 
@@ -111,13 +111,21 @@ public:
 
 	}
 
-	_STD_API void _Do_copy(_String_guts& other) noexcept {
+	_STD_API void _Do_copy(const _String_guts& other) noexcept {
+		if (other._Is_uninitialized()) {
+			// copying an empty string, keep our buffer but empty it.
+			if (_Ptr) {
+				_Length = 0;
+				RAW_STR_BUFF_DEREF(_Ptr) = '\0';
+			}
+			return;
+		}
 		_Overwrite_init(other._Ptr);
 	}
 	_STD_API void _Do_move(_String_guts& other) noexcept {
-		other._Ptr = _Ptr;
-		other._Length = _Length;
-		other._Capacity;
+		_Ptr = other._Ptr;
+		_Length = other._Length;
+		_Capacity = other._Capacity;
 
 		other._Ptr = NULL;
 		other._Length = 0;
@@ -1,12 +1,202 @@
 #include "all"
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <filesystem>
+#include <mutex>
+#include <random>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 using namespace stud;
 
+// `stud bench` times the hot paths against their baselines. Each run takes the best of a few
+// rounds, so the numbers are only comparable on the same machine.
+static constexpr int bench_rounds = 5;
+
+template <class F>
+static Duration best_of(F&& run)
+{
+	auto best = Duration::from_secs(3600);
+	for (int round = 0; round < bench_rounds; ++round) {
+		const auto start = Instant::now();
+		run();
+		best = std::min(best, start.elapsed());
+	}
+	return best;
+}
+
+struct SortRecord {
+	uint32 key;
+	uint32 payload;
+};
+
+static void bench_radix_sort()
+{
+	std::mt19937_64 rng(42);
+	for (const size_t count : { size_t{ 1'000 }, size_t{ 100'000 }, size_t{ 1'000'000 } }) {
+		std::vector<uint64> keys(count);
+		for (auto& key : keys)
+			key = rng();
+		std::vector<SortRecord> records(count);
+		for (auto& record : records)
+			record = { static_cast<uint32>(rng()), 0 };
+		const auto by_key = [](const SortRecord& record) { return record.key; };
+
+		std::vector<uint64> work;
+		std::vector<SortRecord> work_records;
+		const auto std_sort = best_of([&] { work = keys; std::sort(work.begin(), work.end()); });
+		const auto radix = best_of([&] { work = keys; radix_sort(work); });
+		const auto par_radix = best_of([&] { work = keys; par::radix_sort(work); });
+		const auto std_records = best_of([&] {
+			work_records = records;
+			std::stable_sort(work_records.begin(), work_records.end(), [](const SortRecord& a, const SortRecord& b) { return a.key < b.key; });
+		});
+		const auto radix_records = best_of([&] { work_records = records; radix_sort(work_records, by_key); });
+
+		std::printf("sort %9zu x uint64: std::sort %s, radix_sort %s, par::radix_sort %s\n", count,
+			std_sort.to_string().c_str(), radix.to_string().c_str(), par_radix.to_string().c_str());
+		std::printf("sort %9zu x record: std::stable_sort %s, radix_sort %s\n", count,
+			std_records.to_string().c_str(), radix_records.to_string().c_str());
+	}
+}
+
+// Runs body() on `threads` threads at once and waits for all of them.
+template <class F>
+static void run_threads(size_t threads, F&& body)
+{
+	std::vector<std::thread> workers;
+	workers.reserve(threads);
+	for (size_t thread = 0; thread < threads; ++thread)
+		workers.emplace_back(body);
+	for (auto& worker : workers)
+		worker.join();
+}
+
+static void bench_stacks()
+{
+	constexpr size_t ops = 1'000'000;
+
+	// a burst of pushes then pops, so the chunk boundaries are crossed both ways.
+	Stack<uint64> stack;
+	const auto growable = best_of([&] {
+		for (size_t index = 0; index < ops; ++index)
+			stack.push(index);
+		for (size_t index = 0; index < ops; ++index)
+			DISCARD(stack.pop());
+	});
+	std::vector<uint64> vector;
+	const auto std_vector = best_of([&] {
+		for (size_t index = 0; index < ops; ++index)
+			vector.push_back(index);
+		for (size_t index = 0; index < ops; ++index)
+			vector.pop_back();
+	});
+	std::printf("stack %zu push+pop: Stack %s, std::vector %s\n", ops,
+		growable.to_string().c_str(), std_vector.to_string().c_str());
+
+	// every thread pushes one and pops one against the same head, the free list use case.
+	for (const size_t threads : { size_t{ 1 }, size_t{ 2 }, size_t{ 4 }, size_t{ 8 } }) {
+		const size_t per_thread = ops / threads;
+
+		AtomicStack<uint64> lock_free;
+		lock_free.reserve(threads);
+		const auto atomic = best_of([&] {
+			run_threads(threads, [&] {
+				for (size_t index = 0; index < per_thread; ++index) {
+					lock_free.push(index);
+					DISCARD(lock_free.pop());
+				}
+			});
+		});
+
+		std::mutex lock;
+		std::vector<uint64> locked;
+		locked.reserve(threads);
+		const auto mutex = best_of([&] {
+			run_threads(threads, [&] {
+				for (size_t index = 0; index < per_thread; ++index) {
+					{ std::lock_guard guard(lock); locked.push_back(index); }
+					{ std::lock_guard guard(lock); locked.pop_back(); }
+				}
+			});
+		});
+
+		std::printf("stack %zu push+pop on %zu threads: AtomicStack %s, std::mutex + std::vector %s\n", ops, threads,
+			atomic.to_string().c_str(), mutex.to_string().c_str());
+	}
+}
+
+static void bench_iso8601()
+{
+	constexpr size_t count = 1'000'000;
+
+	std::mt19937_64 rng(42);
+	std::vector<DateTime> times;
+	times.reserve(count);
+	for (size_t index = 0; index < count; ++index)
+		times.push_back(DateTime::from_unix_millis(static_cast<int64>(rng() % 4'102'444'800'000ull)));
+
+	std::vector<char> text(count * Iso8601MaxLength);
+	std::vector<size_t> lengths(count);
+	const auto format = best_of([&] {
+		for (size_t index = 0; index < count; ++index)
+			lengths[index] = format_iso8601(times[index], text.data() + index * Iso8601MaxLength, Iso8601MaxLength);
+	});
+	char scratch[64];
+	const auto with_snprintf = best_of([&] {
+		for (const auto& time : times) {
+			DISCARD(std::snprintf(scratch, sizeof(scratch), "%04zu-%02zu-%02zuT%02zu:%02zu:%02zu.%03zuZ", time.year(),
+				static_cast<size_t>(time.month()) + 1, time.month_day(), time.hours(), time.minutes(), time.seconds(), time.millis()));
+		}
+	});
+	std::printf("iso8601 format %zu: format_iso8601 %s, snprintf %s\n", count,
+		format.to_string().c_str(), with_snprintf.to_string().c_str());
+
+	// the sum keeps the parses from being thrown away.
+	int64 checksum = 0;
+	const auto parse = best_of([&] {
+		for (size_t index = 0; index < count; ++index) {
+			auto millis = parse_iso8601_millis(std::string_view(text.data() + index * Iso8601MaxLength, lengths[index]));
+			checksum += millis.is_okay() ? millis.view() : 0;
+		}
+	});
+	const auto with_sscanf = best_of([&] {
+		for (size_t index = 0; index < count; ++index) {
+			std::string_view field(text.data() + index * Iso8601MaxLength, lengths[index]);
+			std::memcpy(scratch, field.data(), field.size());
+			scratch[field.size()] = '\0';
+			int year, month, day, hours, minutes, seconds, millis;
+			if (std::sscanf(scratch, "%d-%d-%dT%d:%d:%d.%dZ", &year, &month, &day, &hours, &minutes, &seconds, &millis) == 7)
+				checksum += millis;
+		}
+	});
+	std::printf("iso8601 parse %zu: parse_iso8601_millis %s, sscanf %s (%lld)\n", count,
+		parse.to_string().c_str(), with_sscanf.to_string().c_str(), static_cast<long long>(checksum & 1));
+}
+
+static void run_benchmarks()
+{
+	bench_radix_sort();
+	bench_stacks();
+	bench_iso8601();
+}
+
 int main(int argc, char** argv)
 {
 	auto set = BitSet<640>{};
 	auto storage = as_const(set.storage());
+
+	// a probe that is not a string is converted to the key type before hashing.
+	constexpr auto weights = make_static_map<double, int>({ { 5.0, 1 }, { 1.5, 2 } });
+	static_assert(weights.find(5) != nullptr && *weights.find(5) == 1);
+
+	HashMap<double, int> scores;
+	scores.insert(5.0, 1);
+	panic(IF(!scores.contains(5)), "HashMap<double, V> missed an int probe.");
+
+	if (argc > 1 && std::string_view(argv[1]) == "bench")
+		run_benchmarks();
 }
\ No newline at end of file
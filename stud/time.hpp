@@ -5,9 +5,31 @@
 #include <Windows.h>
 #include <ctime>
 #include <string>
+#include <compare>
+#include <cstdio>
+#include <time.h>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <cstdlib>
 #include "io.hpp"
 #include "result.hpp"
 #include "utility.hpp"
+#include "stddef.hpp"
+
+_STD_DETAIL_API
+
+_NODISCARD _STD_API std::string_view _Unknown_name(Case c) noexcept {
+    return c == Case::Capitalized ? "Unknown" : c == Case::Lower ? "unknown" : "UNKNOWN";
+}
+
+_STD_API_END
 
 _STD_API_BEGIN
 
@@ -30,34 +52,24 @@ enum Month : size_t {
 };
 
 inline static std::string_view month_to_string(Month month, Case c = Case::Capitalized) {
-    switch (month) {
-    case Month::January:
-        return c == Case::Capitalized ? "January" : c == Case::Lower ? "january" : "JANUARY";
-    case Month::February:
-        return c == Case::Capitalized ? "February" : c == Case::Lower ? "february" : "FEBRUARY";
-    case Month::March:
-        return c == Case::Capitalized ? "March" : c == Case::Lower ? "march" : "MARCH";
-    case Month::April:
-        return c == Case::Capitalized ? "April" : c == Case::Lower ? "april" : "APRIL";
-    case Month::May:
-        return c == Case::Capitalized ? "May" : c == Case::Lower ? "may" : "MAY";
-    case Month::June:
-        return c == Case::Capitalized ? "June" : c == Case::Lower ? "june" : "JUNE";
-    case Month::July:
-        return c == Case::Capitalized ? "July" : c == Case::Lower ? "july" : "JULY";
-    case Month::August:
-        return c == Case::Capitalized ? "August" : c == Case::Lower ? "august" : "AUGUST";
-    case Month::September:
-        return c == Case::Capitalized ? "September" : c == Case::Lower ? "september" : "SEPTEMBER";
-    case Month::October:
-        return c == Case::Capitalized ? "October" : c == Case::Lower ? "october" : "OCTOBER";
-    case Month::November:
-        return c == Case::Capitalized ? "November" : c == Case::Lower ? "november" : "NOVEMBER";
-    case Month::December:
-        return c == Case::Capitalized ? "December" : c == Case::Lower ? "december" : "DECEMBER";
-    default:
-        return c == Case::Capitalized ? "Unknown" : c == Case::Lower ? "unknown" : "UNKNOWN";
-    }
+    // [month][case], the columns in the order of Case.
+    static constexpr std::string_view _Names[12][3] = {
+        { "january", "January", "JANUARY" },
+        { "february", "February", "FEBRUARY" },
+        { "march", "March", "MARCH" },
+        { "april", "April", "APRIL" },
+        { "may", "May", "MAY" },
+        { "june", "June", "JUNE" },
+        { "july", "July", "JULY" },
+        { "august", "August", "AUGUST" },
+        { "september", "September", "SEPTEMBER" },
+        { "october", "October", "OCTOBER" },
+        { "november", "November", "NOVEMBER" },
+        { "december", "December", "DECEMBER" },
+    };
+    if (static_cast<size_t>(month) >= std::size(_Names) || static_cast<size_t>(c) >= std::size(_Names[0]))
+        return _DETAIL _Unknown_name(c);
+    return _Names[month][static_cast<size_t>(c)];
 }
 
 // Sunday is first to be compliant with the <ctime> api
@@ -73,94 +85,95 @@ enum Day : size_t {
 
 inline static std::string_view day_to_string(Day day, Case c = Case::Capitalized)
 {
-    switch (day) {
-    case Day::Monday:
-        return c == Case::Capitalized ? "Monday" : c == Case::Lower ? "monday" : "MONDAY";
-    case Day::Tuesday:
-        return c == Case::Capitalized ? "Tuesday" : c == Case::Lower ? "tuesday" : "TUESDAY";
-    case Day::Wednesday:
-        return c == Case::Capitalized ? "Wednesday" : c == Case::Lower ? "wednesday" : "WEDNESDAY";
-    case Day::Thursday:
-        return c == Case::Capitalized ? "Thursday" : c == Case::Lower ? "thursday" : "THURSDAY";
-    case Day::Friday:
-        return c == Case::Capitalized ? "Friday" : c == Case::Lower ? "friday" : "FRIDAY";
-    case Day::Saturday:
-        return c == Case::Capitalized ? "Saturday" : c == Case::Lower ? "saturday" : "SATURDAY";
-    case Day::Sunday:
-        return c == Case::Capitalized ? "Sunday" : c == Case::Lower ? "sunday" : "SUNDAY";
-    default:
-        return c == Case::Capitalized ? "Unknown" : c == Case::Lower ? "unknown" : "UNKNOWN";
-    }
+    // [day][case], the columns in the order of Case.
+    static constexpr std::string_view _Names[7][3] = {
+        { "sunday", "Sunday", "SUNDAY" },
+        { "monday", "Monday", "MONDAY" },
+        { "tuesday", "Tuesday", "TUESDAY" },
+        { "wednesday", "Wednesday", "WEDNESDAY" },
+        { "thursday", "Thursday", "THURSDAY" },
+        { "friday", "Friday", "FRIDAY" },
+        { "saturday", "Saturday", "SATURDAY" },
+    };
+    if (static_cast<size_t>(day) >= std::size(_Names) || static_cast<size_t>(c) >= std::size(_Names[0]))
+        return _DETAIL _Unknown_name(c);
+    return _Names[day][static_cast<size_t>(c)];
 }
 inline static std::string_view get_postfix_for_date_number(std::size_t number) {
-    switch (number) {
-    case 1:
-        return "st";
-    case 2:
-        return "nd";
-    case 3:
-        return "rd";
-    case 4:
-        return "th";
-    case 5:
-        return "th";
-    case 6:
-        return "th";
-    case 7:
-        return "th";
-    case 8:
-        return "th";
-    case 9:
-        return "th";
-    case 10:
-        return "th";
-    case 11:
-        return "th";
-    case 12:
-        return "th";
-    case 13:
-        return "th";
-    case 14:
-        return "th";
-    case 15:
-        return "th";
-    case 16:
-        return "th";
-    case 17:
-        return "th";
-    case 18:
-        return "th";
-    case 19:
-        return "th";
-    case 20:
-        return "th";
-    case 21:
-        return "st";
-    case 22:
-        return "nd";
-    case 23:
-        return "rd";
-    case 24:
-        return "th";
-    case 25:
-        return "th";
-    case 26:
-        return "th";
-    case 27:
-        return "th";
-    case 28:
-        return "th";
-    case 29:
-        return "th";
-    case 30:
-        return "th";
-    case 31:
-        return "st";
-    default:
+    if (number == 0 || number > 31)
         return "";
+    if (number >= 11 && number <= 13)
+        return "th";
+    constexpr std::string_view _Postfixes[10] = { "th", "st", "nd", "rd", "th", "th", "th", "th", "th", "th" };
+    return _Postfixes[number % 10];
+}
+
+_STD_API_END
+
+_STD_DETAIL_API
+
+struct _Digit_pair_table {
+    char pairs[200];
+};
+
+// "00" "01" ... "99", two digits are written with one lookup.
+inline constexpr _Digit_pair_table _Digit_pairs = []() {
+    _Digit_pair_table _Table = {};
+    for (size_t i = 0; i < 100; ++i) {
+        _Table.pairs[i * 2] = static_cast<char>('0' + i / 10);
+        _Table.pairs[i * 2 + 1] = static_cast<char>('0' + i % 10);
     }
+    return _Table;
+}();
+
+// Writes the last two digits of value, so out of range fields never read past the table.
+_STD_API char* _Write_2_digits(char* out, size_t value) noexcept {
+    value %= 100;
+    out[0] = _Digit_pairs.pairs[value * 2];
+    out[1] = _Digit_pairs.pairs[value * 2 + 1];
+    return out + 2;
+}
+_STD_API char* _Write_3_digits(char* out, size_t value) noexcept {
+    out[0] = static_cast<char>('0' + value / 100);
+    return _Write_2_digits(out + 1, value % 100);
+}
+_STD_API char* _Write_4_digits(char* out, size_t value) noexcept {
+    _Write_2_digits(out, (value / 100) % 100);
+    return _Write_2_digits(out + 2, value % 100);
+}
+// No padding, for numbers of unknown width (at most 20 characters).
+_STD_API char* _Write_unsigned(char* out, uint64 value) noexcept {
+    char _Reversed[20];
+    size_t _Count = 0;
+    do {
+        _Reversed[_Count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (_Count)
+        *out++ = _Reversed[--_Count];
+    return out;
+}
+
+// civil date -> days since 1970-01-01, see http://howardhinnant.github.io/date_algorithms.html
+_STD_API int64 _Days_from_civil(int64 year, uint32 month, uint32 day) noexcept {
+    year -= month <= 2;
+    const int64 _Era = (year >= 0 ? year : year - 399) / 400;
+    const int64 _Yoe = year - _Era * 400;
+    const int64 _Doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const int64 _Doe = _Yoe * 365 + _Yoe / 4 - _Yoe / 100 + _Doy;
+    return _Era * 146097 + _Doe - 719468;
+}
+
+_STD_API uint32 _Days_in_month(int64 year, uint32 month) noexcept {
+    constexpr uint8_t _Lengths[13] = { 0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    const bool _Leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return _Lengths[month] + (month == 2 && _Leap);
 }
 
+_STD_API_END
+
+_STD_API_BEGIN
+
 struct _DatetimeInternals {
     size_t Year, Month, Day, Millis;
     size_t Seconds, Minutes, Hours;
@@ -173,24 +186,8 @@ class DateTime {
 private:
     _DatetimeInternals _Data;
 public:
-    inline DateTime(const TimeConvert convert = TimeConvert::Local) {
-        // The default constructor gets the NOW time.
-        auto tt = std::time(NULL);
-        struct tm* timeInfo = convert == TimeConvert::Local ? std::localtime(&tt) : std::gmtime(&tt);
-        SYSTEMTIME stime = {};
-        GetSystemTime(&stime);
-
-        _Data.Day = stime.wDay;
-        _Data.Minutes = stime.wHour;
-        _Data.Seconds = stime.wSecond;
-        _Data.Millis = stime.wMilliseconds;
-        _Data.Year = stime.wYear;
-
-        _Data.Day = timeInfo->tm_mday;
-        _Data.DayOfMonth = timeInfo->tm_mday;
-        _Data.IsDaylightSaving = static_cast<bool>(timeInfo->tm_isdst);
-        _Data.MonthsSinceJanuary = timeInfo->tm_mon;
-    }
+    // The current time, converted through TimeZone::local() (or UTC).
+    inline DateTime(const TimeConvert convert = TimeConvert::Local);
     inline DateTime(const _DatetimeInternals* data) {
         std::memcpy(&_Data, data, sizeof(_DatetimeInternals));
     }
@@ -235,6 +232,7 @@ public:
     inline size_t seconds() const noexcept { return _Data.Seconds; }
     inline size_t minutes() const noexcept { return _Data.Minutes; }
     inline size_t hours() const noexcept { return _Data.Hours; }
+    inline size_t millis() const noexcept { return _Data.Millis; }
 
     inline size_t month_day() const noexcept { return _Data.DayOfMonth; }
     inline Month month() const noexcept { return static_cast<Month>(_Data.Month); }
@@ -248,30 +246,1091 @@ public:
     }
 
     inline std::string time() const noexcept {
-        return stud::format("{:02}:{:02}:{:02}", hours(), minutes(), seconds());
+        char _Buffer[8];
+        auto* _Out = _DETAIL _Write_2_digits(_Buffer, hours());
+        *_Out++ = ':';
+        _Out = _DETAIL _Write_2_digits(_Out, minutes());
+        *_Out++ = ':';
+        _DETAIL _Write_2_digits(_Out, seconds());
+        return std::string(_Buffer, sizeof(_Buffer));
     }
     inline std::string date() const noexcept {
-        return stud::format("{:02}/{:02}/{:02}", _Data.DayOfMonth, static_cast<size_t>(month()) + 1, year());
+        char _Buffer[32];
+        auto* _Out = _DETAIL _Write_2_digits(_Buffer, _Data.DayOfMonth);
+        *_Out++ = '/';
+        _Out = _DETAIL _Write_2_digits(_Out, static_cast<size_t>(month()) + 1);
+        *_Out++ = '/';
+        if (year() < 10)
+            *_Out++ = '0';
+        _Out = _DETAIL _Write_unsigned(_Out, year());
+        return std::string(_Buffer, _Out);
     }
     inline std::string month_string() const noexcept {
         const auto postfix = get_postfix_for_date_number(this->month_day());
         const auto month = month_to_string(this->month());
 
-        return stud::format("{}{} of {}", month_day(), postfix, month);
+        char _Buffer[64];
+        auto* _Out = _DETAIL _Write_unsigned(_Buffer, month_day());
+        _Out = std::copy(postfix.begin(), postfix.end(), _Out);
+        _Out = std::copy_n(" of ", 4, _Out);
+        _Out = std::copy(month.begin(), month.end(), _Out);
+        return std::string(_Buffer, _Out);
     }
 
     inline static DateTime now_local() noexcept {
-        return DateTime();
+        return DateTime(TimeConvert::Local);
     }
     inline static DateTime now_utc() noexcept {
         return DateTime(TimeConvert::UTC);
     }
+    // Served from CoarseClock::global(), accurate to its resolution (1ms) and never calls into libc.
+    inline static DateTime now_coarse() noexcept;
 
     inline static DateTime none() {
         return DateTime(nullptr);
     }
+
+    inline void _Set_daylight_saving(bool dst) noexcept {
+        _Data.IsDaylightSaving = dst;
+    }
+
+    /// <summary>
+    /// Build a DateTime from milliseconds since the unix epoch, shifted by utc_offset_seconds.
+    /// This is plain integer arithmetic (no libc calls), every field is filled in.
+    /// </summary>
+    inline static DateTime from_unix_millis(int64 millis, int32 utc_offset_seconds = 0) noexcept {
+        auto _Result = DateTime(nullptr);
+        auto& _Out = _Result._Data;
+
+        millis += static_cast<int64>(utc_offset_seconds) * 1000;
+        int64 _Days = millis / 86'400'000;
+        int64 _Ms_of_day = millis % 86'400'000;
+        if (_Ms_of_day < 0) {
+            _Ms_of_day += 86'400'000;
+            --_Days;
+        }
+
+        _Out.Millis = static_cast<size_t>(_Ms_of_day % 1000);
+        _Out.Seconds = static_cast<size_t>((_Ms_of_day / 1000) % 60);
+        _Out.Minutes = static_cast<size_t>((_Ms_of_day / 60'000) % 60);
+        _Out.Hours = static_cast<size_t>(_Ms_of_day / 3'600'000);
+
+        // days -> civil date, see http://howardhinnant.github.io/date_algorithms.html
+        const int64 _Shifted = _Days + 719468;
+        const int64 _Era = (_Shifted >= 0 ? _Shifted : _Shifted - 146096) / 146097;
+        const int64 _Doe = _Shifted - _Era * 146097;
+        const int64 _Yoe = (_Doe - _Doe / 1460 + _Doe / 36524 - _Doe / 146096) / 365;
+        const int64 _Doy = _Doe - (365 * _Yoe + _Yoe / 4 - _Yoe / 100);
+        const int64 _Mp = (5 * _Doy + 2) / 153;
+        const int64 _Day = _Doy - (153 * _Mp + 2) / 5 + 1;
+        const int64 _Month = _Mp < 10 ? _Mp + 3 : _Mp - 9;
+        const int64 _Year = _Yoe + _Era * 400 + (_Month <= 2);
+
+        const bool _Leap = (_Year % 4 == 0 && _Year % 100 != 0) || _Year % 400 == 0;
+        constexpr int64 _Days_before_month[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+
+        _Out.Year = static_cast<size_t>(_Year);
+        _Out.Month = static_cast<size_t>(_Month - 1);
+        _Out.MonthsSinceJanuary = _Out.Month;
+        _Out.Day = static_cast<size_t>(_Day);
+        _Out.DayOfMonth = _Out.Day;
+        _Out.DayOfYear = static_cast<size_t>(_Days_before_month[_Month - 1] + (_Leap && _Month > 2) + _Day - 1);
+        // 1970-01-01 was a Thursday.
+        _Out.WeekDay = static_cast<size_t>(((_Days % 7) + 11) % 7);
+
+        return _Result;
+    }
 };
 
+// "YYYY-MM-DDTHH:MM:SS.mmm+HH:MM", the longest output of format_iso8601.
+inline constexpr size_t Iso8601MaxLength = 29;
+
+_STD_API_END
+
+_STD_DETAIL_API
+
+inline size_t _Format_timestamp(const DateTime& time, char* buffer, size_t length, int32 utc_offset_seconds, bool with_millis) noexcept {
+    // a negative year wraps to a huge size_t, so this also rejects years before 0.
+    if (time.year() > 9999)
+        return 0;
+
+    char _Text[Iso8601MaxLength];
+    char* _Out = _Write_4_digits(_Text, time.year());
+    *_Out++ = '-';
+    _Out = _Write_2_digits(_Out, static_cast<size_t>(time.month()) + 1);
+    *_Out++ = '-';
+    _Out = _Write_2_digits(_Out, time.month_day());
+    *_Out++ = 'T';
+    _Out = _Write_2_digits(_Out, time.hours());
+    *_Out++ = ':';
+    _Out = _Write_2_digits(_Out, time.minutes());
+    *_Out++ = ':';
+    _Out = _Write_2_digits(_Out, time.seconds());
+    if (with_millis) {
+        *_Out++ = '.';
+        _Out = _Write_3_digits(_Out, time.millis());
+    }
+
+    if (utc_offset_seconds == 0) {
+        *_Out++ = 'Z';
+    }
+    else {
+        const int32 _Abs = utc_offset_seconds < 0 ? -utc_offset_seconds : utc_offset_seconds;
+        *_Out++ = utc_offset_seconds < 0 ? '-' : '+';
+        _Out = _Write_2_digits(_Out, static_cast<size_t>(_Abs / 3600));
+        *_Out++ = ':';
+        _Out = _Write_2_digits(_Out, static_cast<size_t>(_Abs / 60) % 60);
+    }
+
+    const auto _Written = static_cast<size_t>(_Out - _Text);
+    if (_Written > length)
+        return 0;
+    std::memcpy(buffer, _Text, _Written);
+    return _Written;
+}
+
+_STD_API_END
+
+_STD_API_BEGIN
+
+/// <summary>
+/// Write `time` as ISO-8601 with millisecond precision ("2024-03-09T14:05:07.042Z"), into a
+/// caller supplied buffer. utc_offset_seconds is the offset `time` was taken at, UTC
+/// is written as 'Z'. Returns the amount of characters written, or 0 when the buffer is too small
+/// or the year is outside 0..9999, which four digits cannot hold.
+/// </summary>
+inline size_t format_iso8601(const DateTime& time, char* buffer, size_t length, int32 utc_offset_seconds = 0) noexcept {
+    return _DETAIL _Format_timestamp(time, buffer, length, utc_offset_seconds, true);
+}
+
+/// <summary>
+/// Write `time` in the RFC 3339 internet profile with second precision ("2024-03-09T14:05:07+01:00").
+/// Same contract as format_iso8601.
+/// </summary>
+inline size_t format_rfc3339(const DateTime& time, char* buffer, size_t length, int32 utc_offset_seconds = 0) noexcept {
+    return _DETAIL _Format_timestamp(time, buffer, length, utc_offset_seconds, false);
+}
+
+enum class DateTimeParseError {
+    TooShort,
+    InvalidCharacter,
+    OutOfRange,
+    TrailingCharacters,
+};
+
+/// <summary>
+/// Parse an ISO-8601 / RFC 3339 timestamp into milliseconds since the unix epoch (UTC).
+/// Accepts "YYYY-MM-DD", optionally followed by 'T' (or a space) and "HH:MM:SS", an optional fraction
+/// (anything past milliseconds is truncated) and an optional 'Z' / "+HH:MM" / "+HHMM" / "+HH" offset.
+/// A timestamp without an offset is taken as UTC.
+///
+/// The fixed width part is validated branch free: every digit is range checked into one error mask
+/// that is tested once, so well formed input runs straight through.
+/// </summary>
+inline Result<int64, DateTimeParseError> parse_iso8601_millis(std::string_view text, int32* utc_offset_seconds = nullptr) noexcept {
+    const char* _Text = text.data();
+    const size_t _Length = text.size();
+    if (_Length < 10)
+        return DateTimeParseError::TooShort;
+
+    uint32 _Bad = 0;
+    const auto _Digit = [&_Bad, _Text](size_t index) noexcept {
+        const uint32 _Value = static_cast<uint32>(static_cast<unsigned char>(_Text[index])) - '0';
+        _Bad |= static_cast<uint32>(_Value > 9);
+        return _Value;
+    };
+    const auto _Pair = [&_Digit](size_t index) noexcept {
+        return _Digit(index) * 10 + _Digit(index + 1);
+    };
+
+    const int64 _Year = _Pair(0) * 100 + _Pair(2);
+    const uint32 _Month = _Pair(5);
+    const uint32 _Day = _Pair(8);
+    _Bad |= static_cast<uint32>(_Text[4] != '-') | static_cast<uint32>(_Text[7] != '-');
+
+    uint32 _Hour = 0, _Minute = 0, _Second = 0, _Millis = 0;
+    int32 _Offset = 0;
+    size_t _Pos = 10;
+
+    if (_Length > 10) {
+        if (_Length < 19)
+            return DateTimeParseError::TooShort;
+        const char _Sep = _Text[10];
+        _Bad |= static_cast<uint32>(_Sep != 'T') & static_cast<uint32>(_Sep != 't') & static_cast<uint32>(_Sep != ' ');
+        _Bad |= static_cast<uint32>(_Text[13] != ':') | static_cast<uint32>(_Text[16] != ':');
+        _Hour = _Pair(11);
+        _Minute = _Pair(14);
+        _Second = _Pair(17);
+        _Pos = 19;
+
+        if (_Pos < _Length && (_Text[_Pos] == '.' || _Text[_Pos] == ',')) {
+            ++_Pos;
+            size_t _Digits = 0;
+            while (_Pos < _Length && static_cast<uint32>(static_cast<unsigned char>(_Text[_Pos]) - '0') <= 9) {
+                if (_Digits < 3)
+                    _Millis = _Millis * 10 + (_Text[_Pos] - '0');
+                ++_Digits;
+                ++_Pos;
+            }
+            if (_Digits == 0)
+                return DateTimeParseError::InvalidCharacter;
+            for (; _Digits < 3; ++_Digits)
+                _Millis *= 10;
+        }
+
+        if (_Pos < _Length) {
+            const char _Zone = _Text[_Pos];
+            if (_Zone == 'Z' || _Zone == 'z') {
+                ++_Pos;
+            }
+            else if (_Zone == '+' || _Zone == '-') {
+                if (_Pos + 3 > _Length)
+                    return DateTimeParseError::TooShort;
+                const uint32 _Offset_hours = _Pair(_Pos + 1);
+                uint32 _Offset_minutes = 0;
+                _Pos += 3;
+                if (_Pos < _Length && _Text[_Pos] == ':') {
+                    // "+HH:" needs both minute digits after the colon.
+                    if (_Pos + 3 > _Length)
+                        return DateTimeParseError::TooShort;
+                    ++_Pos;
+                }
+                if (_Pos + 2 <= _Length) {
+                    _Offset_minutes = _Pair(_Pos);
+                    _Pos += 2;
+                }
+                if (_Offset_hours > 23 || _Offset_minutes > 59)
+                    return DateTimeParseError::OutOfRange;
+                _Offset = static_cast<int32>(_Offset_hours * 3600 + _Offset_minutes * 60);
+                if (_Zone == '-')
+                    _Offset = -_Offset;
+            }
+        }
+    }
+
+    if (_Bad)
+        return DateTimeParseError::InvalidCharacter;
+    if (_Pos != _Length)
+        return DateTimeParseError::TrailingCharacters;
+    if (_Month - 1 > 11 || _Day - 1 >= _DETAIL _Days_in_month(_Year, _Month) || _Hour > 23 || _Minute > 59 || _Second > 60)
+        return DateTimeParseError::OutOfRange;
+    if (_Second == 60) {
+        // leap second, DateTime has no way to represent it.
+        _Second = 59;
+        _Millis = 999;
+    }
+
+    if (utc_offset_seconds)
+        *utc_offset_seconds = _Offset;
+
+    const int64 _Days = _DETAIL _Days_from_civil(_Year, _Month, _Day);
+    const int64 _Local_millis = (_Days * 86400 + _Hour * 3600 + _Minute * 60 + _Second) * 1000 + _Millis;
+    return int64{ _Local_millis - static_cast<int64>(_Offset) * 1000 };
+}
+
+/// <summary>
+/// Parse an ISO-8601 timestamp (see parse_iso8601_millis). The fields of the DateTime are the ones
+/// that were written, i.e local to the offset in the text.
+/// </summary>
+inline Result<DateTime, DateTimeParseError> parse_iso8601(std::string_view text) noexcept {
+    int32 _Offset = 0;
+    auto _Millis = parse_iso8601_millis(text, &_Offset);
+    if (_Millis.is_err())
+        return _Millis.get_err();
+    return DateTime::from_unix_millis(_Millis.view(), _Offset);
+}
+
+enum class TimeZoneError {
+    NotFound,
+    InvalidData,
+};
+
+/// <summary>
+/// A timezone loaded once from zoneinfo (TZif, RFC 8536) and evaluated without libc.
+///
+/// Looking up an offset first checks a cached [begin, end) range in which the offset is known to be
+/// constant, so converting "now" is a range check and an add. Only when the range is left (at most
+/// twice a year for zones with DST) is the transition table or the POSIX rule in the file footer consulted.
+///
+/// Where no zoneinfo is available (Windows, or a broken install) the zone falls back to asking the C
+/// runtime, cached in 15 minute slices.
+/// </summary>
+class TimeZone {
+private:
+    struct _Local_type {
+        int32 offset;
+        bool dst;
+    };
+
+    // The POSIX TZ rule, e.g "CET-1CEST,M3.5.0,M10.5.0/3"
+    struct _Rule_date {
+        // 'M' (month.week.day), 'J' (1-365, Feb 29th never counted) or 'N' (0-365).
+        char kind;
+        uint32 month, week, day;
+        int32 time;
+    };
+    struct _Posix_rule {
+        int32 std_offset{ 0 };
+        int32 dst_offset{ 0 };
+        bool has_dst{ false };
+        _Rule_date start{}, end{};
+    };
+
+    struct _Cached_range {
+        int64 begin, end;
+        int32 offset;
+        bool dst;
+    };
+
+    std::string _Name;
+    std::vector<int64> _Transition_times;
+    std::vector<uint8_t> _Transition_types;
+    std::vector<_Local_type> _Types;
+    _Posix_rule _Footer;
+    bool _Has_footer{ false };
+    bool _Use_libc{ false };
+
+    // sequence lock around the cached range. Any thread may fill it, a writer that loses the
+    // race for the lock simply does not cache.
+    mutable std::atomic<uint64> _Cache_sequence{ 0 };
+    mutable std::atomic<int64> _Cache_begin{ 1 };
+    mutable std::atomic<int64> _Cache_end{ 0 };
+    mutable std::atomic<int64> _Cache_value{ 0 };
+public:
+    inline TimeZone() noexcept
+        : _Name("UTC")
+    {}
+    inline TimeZone(const TimeZone& other) noexcept {
+        *this = other;
+    }
+    inline TimeZone& operator=(const TimeZone& other) noexcept {
+        _Name = other._Name;
+        _Transition_times = other._Transition_times;
+        _Transition_types = other._Transition_types;
+        _Types = other._Types;
+        _Footer = other._Footer;
+        _Has_footer = other._Has_footer;
+        _Use_libc = other._Use_libc;
+        _Cache_sequence.store(0, std::memory_order_relaxed);
+        _Cache_begin.store(1, std::memory_order_relaxed);
+        _Cache_end.store(0, std::memory_order_relaxed);
+        return *this;
+    }
+
+    _NODISCARD inline static TimeZone utc() noexcept {
+        return TimeZone();
+    }
+
+    // A zone that is always utc_offset_seconds away from UTC.
+    _NODISCARD inline static TimeZone fixed(int32 utc_offset_seconds) noexcept {
+        auto _Zone = TimeZone();
+        _Zone._Name = "fixed";
+        _Zone._Footer.std_offset = utc_offset_seconds;
+        _Zone._Has_footer = true;
+        return _Zone;
+    }
+
+    /// <summary>
+    /// Load a zone by its IANA name ("Europe/London") from $TZDIR or /usr/share/zoneinfo,
+    /// or from an absolute path to a TZif file.
+    /// </summary>
+    inline static Result<TimeZone, TimeZoneError> load(std::string_view name) noexcept {
+        auto _Path = std::string();
+        if (!name.empty() && name.front() == '/') {
+            _Path = name;
+        }
+        else {
+            const char* _Dir = std::getenv("TZDIR");
+            _Path = _Dir ? _Dir : "/usr/share/zoneinfo";
+            _Path.push_back('/');
+            _Path.append(name);
+        }
+
+        std::ifstream _File(_Path, std::ios::binary);
+        if (!_File)
+            return TimeZoneError::NotFound;
+        const auto _Bytes = std::string(std::istreambuf_iterator<char>(_File), std::istreambuf_iterator<char>());
+
+        auto _Zone = TimeZone();
+        if (!_Zone._Parse_tzif(_Bytes))
+            return TimeZoneError::InvalidData;
+        _Zone._Name = name;
+        return std::move(_Zone);
+    }
+
+    /// <summary>
+    /// The zone of this process, resolved once: $TZ (a zone name, a path or a POSIX rule),
+    /// then /etc/localtime, then the C runtime.
+    /// </summary>
+    inline static const TimeZone& local() noexcept {
+        static const TimeZone _Local = []() {
+            const char* _Tz = std::getenv("TZ");
+            if (_Tz && *_Tz) {
+                auto _Name = std::string_view(_Tz);
+                if (_Name.front() == ':')
+                    _Name.remove_prefix(1);
+                auto _Loaded = load(_Name);
+                if (_Loaded.is_okay())
+                    return _Loaded.get();
+
+                auto _Zone = TimeZone();
+                if (_Parse_posix_rule(_Name, _Zone._Footer)) {
+                    _Zone._Name = _Name;
+                    _Zone._Has_footer = true;
+                    return _Zone;
+                }
+            }
+
+            auto _System = load("/etc/localtime");
+            if (_System.is_okay()) {
+                auto _Zone = _System.get();
+                _Zone._Name = "localtime";
+                return _Zone;
+            }
+
+            auto _Zone = TimeZone();
+            _Zone._Name = "libc";
+            _Zone._Use_libc = true;
+            return _Zone;
+        }();
+        return _Local;
+    }
+
+    _NODISCARD inline std::string_view name() const noexcept {
+        return _Name;
+    }
+
+    // Seconds east of UTC at the given instant.
+    _NODISCARD inline int32 utc_offset_at(int64 unix_seconds) const noexcept {
+        return _Lookup(unix_seconds).offset;
+    }
+
+    _NODISCARD inline bool is_dst_at(int64 unix_seconds) const noexcept {
+        return _Lookup(unix_seconds).dst;
+    }
+
+    // The local time in this zone at the given instant.
+    _NODISCARD inline DateTime to_local(int64 unix_millis) const noexcept {
+        const int64 _Seconds = unix_millis >= 0 ? unix_millis / 1000 : (unix_millis - 999) / 1000;
+        const auto _Range = _Lookup(_Seconds);
+        auto _Result = DateTime::from_unix_millis(unix_millis, _Range.offset);
+        _Result._Set_daylight_saving(_Range.dst);
+        return _Result;
+    }
+
+private:
+    inline _Cached_range _Lookup(int64 unix_seconds) const noexcept {
+        // fast path, the instant is inside of the last range looked up.
+        for (;;) {
+            const auto _Before = _Cache_sequence.load(std::memory_order_acquire);
+            if (_Before & 1)
+                break;
+            const auto _Begin = _Cache_begin.load(std::memory_order_relaxed);
+            const auto _End = _Cache_end.load(std::memory_order_relaxed);
+            const auto _Value = _Cache_value.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_Cache_sequence.load(std::memory_order_relaxed) != _Before)
+                continue;
+            if (unix_seconds >= _Begin && unix_seconds < _End) [[likely]]
+                return _Cached_range{ _Begin, _End, static_cast<int32>(_Value >> 1), (_Value & 1) != 0 };
+            break;
+        }
+
+        const auto _Range = _Compute(unix_seconds);
+
+        auto _Seq = _Cache_sequence.load(std::memory_order_relaxed);
+        if (!(_Seq & 1) && _Cache_sequence.compare_exchange_strong(_Seq, _Seq + 1, std::memory_order_acquire)) {
+            std::atomic_thread_fence(std::memory_order_release);
+            _Cache_begin.store(_Range.begin, std::memory_order_relaxed);
+            _Cache_end.store(_Range.end, std::memory_order_relaxed);
+            _Cache_value.store(static_cast<int64>(_Range.offset) * 2 + (_Range.dst ? 1 : 0), std::memory_order_relaxed);
+            _Cache_sequence.store(_Seq + 2, std::memory_order_release);
+        }
+        return _Range;
+    }
+
+    inline _Cached_range _Compute(int64 t) const noexcept {
+        constexpr int64 _Min = INT64_MIN / 4;
+        constexpr int64 _Max = INT64_MAX / 4;
+
+        if (_Use_libc)
+            return _Compute_libc(t);
+
+        if (_Transition_times.empty() || t < _Transition_times.front()) {
+            if (_Transition_times.empty() && _Has_footer)
+                return _Compute_rule(t);
+            const auto _First = _Types.empty() ? _Local_type{ 0, false } : _Types.front();
+            return _Cached_range{ _Min, _Transition_times.empty() ? _Max : _Transition_times.front(), _First.offset, _First.dst };
+        }
+
+        const auto _After = std::upper_bound(_Transition_times.begin(), _Transition_times.end(), t);
+        const auto _Index = static_cast<size_t>(_After - _Transition_times.begin()) - 1;
+        if (_After == _Transition_times.end() && _Has_footer) {
+            auto _Range = _Compute_rule(t);
+            if (_Range.begin < _Transition_times.back())
+                _Range.begin = _Transition_times.back();
+            return _Range;
+        }
+
+        const auto& _Type = _Types[_Transition_types[_Index]];
+        return _Cached_range{ _Transition_times[_Index], _After == _Transition_times.end() ? _Max : *_After, _Type.offset, _Type.dst };
+    }
+
+    // Seconds (UTC) at which a rule date happens in the given year, for a zone currently at `offset`.
+    static inline int64 _Rule_instant(const _Rule_date& rule, int64 year, int32 offset) noexcept {
+        int64 _Days = 0;
+        const bool _Leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        if (rule.kind == 'M') {
+            const int64 _First = _DETAIL _Days_from_civil(year, rule.month, 1);
+            const int64 _First_weekday = ((_First % 7) + 11) % 7;
+            int64 _Day = 1 + (static_cast<int64>(rule.day) - _First_weekday + 7) % 7 + (static_cast<int64>(rule.week) - 1) * 7;
+            while (_Day > _DETAIL _Days_in_month(year, rule.month))
+                _Day -= 7;
+            _Days = _First + _Day - 1;
+        }
+        else if (rule.kind == 'J') {
+            _Days = _DETAIL _Days_from_civil(year, 1, 1) + rule.day - 1 + (_Leap && rule.day >= 60);
+        }
+        else {
+            _Days = _DETAIL _Days_from_civil(year, 1, 1) + rule.day;
+        }
+        return _Days * 86400 + rule.time - offset;
+    }
+
+    inline _Cached_range _Compute_rule(int64 t) const noexcept {
+        constexpr int64 _Min = INT64_MIN / 4;
+        constexpr int64 _Max = INT64_MAX / 4;
+        const auto& _Rule = _Footer;
+        if (!_Rule.has_dst)
+            return _Cached_range{ _Min, _Max, _Rule.std_offset, false };
+
+        const int64 _Year = static_cast<int64>(DateTime::from_unix_millis(t * 1000).year());
+        const int64 _Year_begin = _DETAIL _Days_from_civil(_Year, 1, 1) * 86400;
+        const int64 _Year_end = _DETAIL _Days_from_civil(_Year + 1, 1, 1) * 86400;
+        // daylight saving starts at standard time and ends at daylight time.
+        const int64 _Start = _Rule_instant(_Rule.start, _Year, _Rule.std_offset);
+        const int64 _End = _Rule_instant(_Rule.end, _Year, _Rule.dst_offset);
+
+        const int64 _Cuts[4] = { _Year_begin, _Start < _End ? _Start : _End, _Start < _End ? _End : _Start, _Year_end };
+        int64 _Begin = _Cuts[0], _Finish = _Cuts[3];
+        for (size_t i = 0; i < 3; ++i) {
+            if (t >= _Cuts[i] && t < _Cuts[i + 1]) {
+                _Begin = _Cuts[i];
+                _Finish = _Cuts[i + 1];
+            }
+        }
+
+        const bool _Dst = _Start < _End ? (t >= _Start && t < _End) : (t < _End || t >= _Start);
+        return _Cached_range{ _Begin, _Finish, _Dst ? _Rule.dst_offset : _Rule.std_offset, _Dst };
+    }
+
+    static inline _Cached_range _Compute_libc(int64 t) noexcept {
+        // Offsets only ever change on a quarter hour.
+        const int64 _Begin = t - (((t % 900) + 900) % 900);
+        const auto _Tt = static_cast<std::time_t>(t);
+        struct tm _Local = {};
+        struct tm _Utc = {};
+#ifdef _WIN32
+        localtime_s(&_Local, &_Tt);
+        gmtime_s(&_Utc, &_Tt);
+#else
+        localtime_r(&_Tt, &_Local);
+        gmtime_r(&_Tt, &_Utc);
+#endif
+        const int64 _Local_days = _DETAIL _Days_from_civil(_Local.tm_year + 1900, _Local.tm_mon + 1, _Local.tm_mday);
+        const int64 _Utc_days = _DETAIL _Days_from_civil(_Utc.tm_year + 1900, _Utc.tm_mon + 1, _Utc.tm_mday);
+        const int64 _Diff = (_Local_days - _Utc_days) * 86400 + (_Local.tm_hour - _Utc.tm_hour) * 3600
+            + (_Local.tm_min - _Utc.tm_min) * 60 + (_Local.tm_sec - _Utc.tm_sec);
+        return _Cached_range{ _Begin, _Begin + 900, static_cast<int32>(_Diff), _Local.tm_isdst > 0 };
+    }
+
+    inline bool _Parse_tzif(std::string_view bytes) noexcept {
+        const auto _Be32 = [&bytes](size_t at) noexcept {
+            const auto* _P = reinterpret_cast<const unsigned char*>(bytes.data() + at);
+            return static_cast<int32>((uint32(_P[0]) << 24) | (uint32(_P[1]) << 16) | (uint32(_P[2]) << 8) | uint32(_P[3]));
+        };
+        const auto _Be64 = [&_Be32](size_t at) noexcept {
+            return static_cast<int64>((static_cast<uint64>(static_cast<uint32>(_Be32(at))) << 32) | static_cast<uint32>(_Be32(at + 4)));
+        };
+
+        constexpr size_t _Header_size = 44;
+        if (bytes.size() < _Header_size || bytes.substr(0, 4) != "TZif")
+            return false;
+
+        const char _Version = bytes[4];
+        size_t _At = 0;
+        size_t _Time_size = 4;
+        for (;;) {
+            if (bytes.size() < _At + _Header_size)
+                return false;
+            const size_t _Isut = static_cast<uint32>(_Be32(_At + 20));
+            const size_t _Isstd = static_cast<uint32>(_Be32(_At + 24));
+            const size_t _Leap = static_cast<uint32>(_Be32(_At + 28));
+            const size_t _Time = static_cast<uint32>(_Be32(_At + 32));
+            const size_t _Type = static_cast<uint32>(_Be32(_At + 36));
+            const size_t _Chars = static_cast<uint32>(_Be32(_At + 40));
+            const size_t _Body = _Time * _Time_size + _Time + _Type * 6 + _Chars + _Leap * (_Time_size + 4) + _Isstd + _Isut;
+            if (bytes.size() < _At + _Header_size + _Body || _Type == 0)
+                return false;
+
+            if (_Version >= '2' && _Time_size == 4) {
+                // skip the legacy 32 bit block, the 64 bit one follows.
+                _At += _Header_size + _Body;
+                _Time_size = 8;
+                continue;
+            }
+
+            size_t _Cursor = _At + _Header_size;
+            _Transition_times.resize(_Time);
+            for (size_t i = 0; i < _Time; ++i, _Cursor += _Time_size)
+                _Transition_times[i] = _Time_size == 8 ? _Be64(_Cursor) : _Be32(_Cursor);
+            _Transition_types.assign(bytes.begin() + _Cursor, bytes.begin() + _Cursor + _Time);
+            _Cursor += _Time;
+            _Types.resize(_Type);
+            for (size_t i = 0; i < _Type; ++i, _Cursor += 6)
+                _Types[i] = _Local_type{ _Be32(_Cursor), bytes[_Cursor + 4] != 0 };
+            for (const auto index : _Transition_types) {
+                if (index >= _Type)
+                    return false;
+            }
+
+            _Cursor = _At + _Header_size + _Body;
+            if (_Time_size == 8 && _Cursor < bytes.size() && bytes[_Cursor] == '\n') {
+                const auto _Footer_end = bytes.find('\n', _Cursor + 1);
+                if (_Footer_end != std::string_view::npos && _Footer_end > _Cursor + 1)
+                    _Has_footer = _Parse_posix_rule(bytes.substr(_Cursor + 1, _Footer_end - _Cursor - 1), _Footer);
+            }
+            return true;
+        }
+    }
+
+    // POSIX offsets are west of UTC ("EST5"), the result is east of UTC.
+    static inline bool _Parse_posix_offset(std::string_view& text, int32& out, bool negate) noexcept {
+        int32 _Sign = 1;
+        if (!text.empty() && (text.front() == '+' || text.front() == '-')) {
+            _Sign = text.front() == '-' ? -1 : 1;
+            text.remove_prefix(1);
+        }
+        int32 _Parts[3] = { 0, 0, 0 };
+        for (size_t part = 0; part < 3; ++part) {
+            if (text.empty() || text.front() < '0' || text.front() > '9')
+                return part != 0;
+            int32 _Value = 0;
+            while (!text.empty() && text.front() >= '0' && text.front() <= '9') {
+                _Value = _Value * 10 + (text.front() - '0');
+                text.remove_prefix(1);
+            }
+            _Parts[part] = _Value;
+            out = _Sign * (_Parts[0] * 3600 + _Parts[1] * 60 + _Parts[2]) * (negate ? -1 : 1);
+            if (text.empty() || text.front() != ':')
+                return true;
+            text.remove_prefix(1);
+        }
+        return true;
+    }
+
+    static inline bool _Parse_posix_name(std::string_view& text) noexcept {
+        if (!text.empty() && text.front() == '<') {
+            const auto _Close = text.find('>');
+            if (_Close == std::string_view::npos)
+                return false;
+            text.remove_prefix(_Close + 1);
+            return true;
+        }
+        size_t _Length = 0;
+        while (_Length < text.size() && ((text[_Length] >= 'a' && text[_Length] <= 'z') || (text[_Length] >= 'A' && text[_Length] <= 'Z')))
+            ++_Length;
+        text.remove_prefix(_Length);
+        return _Length >= 3;
+    }
+
+    static inline bool _Parse_posix_date(std::string_view& text, _Rule_date& out) noexcept {
+        const auto _Number = [&text]() noexcept {
+            uint32 _Value = 0;
+            while (!text.empty() && text.front() >= '0' && text.front() <= '9') {
+                _Value = _Value * 10 + static_cast<uint32>(text.front() - '0');
+                text.remove_prefix(1);
+            }
+            return _Value;
+        };
+        if (text.empty())
+            return false;
+
+        out = _Rule_date{ 'N', 0, 0, 0, 7200 };
+        if (text.front() == 'M') {
+            text.remove_prefix(1);
+            out.kind = 'M';
+            out.month = _Number();
+            if (text.empty() || text.front() != '.')
+                return false;
+            text.remove_prefix(1);
+            out.week = _Number();
+            if (text.empty() || text.front() != '.')
+                return false;
+            text.remove_prefix(1);
+            out.day = _Number();
+            if (out.month < 1 || out.month > 12 || out.week < 1 || out.week > 5 || out.day > 6)
+                return false;
+        }
+        else if (text.front() == 'J') {
+            text.remove_prefix(1);
+            out.kind = 'J';
+            out.day = _Number();
+            if (out.day < 1 || out.day > 365)
+                return false;
+        }
+        else {
+            out.day = _Number();
+            if (out.day > 365)
+                return false;
+        }
+
+        if (!text.empty() && text.front() == '/') {
+            text.remove_prefix(1);
+            return _Parse_posix_offset(text, out.time, false);
+        }
+        return true;
+    }
+
+    static inline bool _Parse_posix_rule(std::string_view text, _Posix_rule& out) noexcept {
+        auto _Rule = _Posix_rule{};
+        if (!_Parse_posix_name(text) || !_Parse_posix_offset(text, _Rule.std_offset, true))
+            return false;
+
+        if (!text.empty()) {
+            if (!_Parse_posix_name(text))
+                return false;
+            _Rule.has_dst = true;
+            _Rule.dst_offset = _Rule.std_offset + 3600;
+            if (!text.empty() && text.front() != ',' && !_Parse_posix_offset(text, _Rule.dst_offset, true))
+                return false;
+            // POSIX leaves the default rules implementation defined, this is the US rule.
+            _Rule.start = _Rule_date{ 'M', 3, 2, 0, 7200 };
+            _Rule.end = _Rule_date{ 'M', 11, 1, 0, 7200 };
+            if (!text.empty()) {
+                if (text.front() != ',')
+                    return false;
+                text.remove_prefix(1);
+                if (!_Parse_posix_date(text, _Rule.start) || text.empty() || text.front() != ',')
+                    return false;
+                text.remove_prefix(1);
+                if (!_Parse_posix_date(text, _Rule.end))
+                    return false;
+            }
+        }
+        if (!text.empty())
+            return false;
+        out = _Rule;
+        return true;
+    }
+};
+
+inline DateTime::DateTime(const TimeConvert convert) {
+    using namespace std::chrono;
+    const int64 _Now = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+    *this = convert == TimeConvert::Local ? TimeZone::local().to_local(_Now) : DateTime::from_unix_millis(_Now);
+}
+
+/// <summary>
+/// A span of time with nanosecond precision. Unlike DateTime, this is just a number,
+/// all arithmetic is integer arithmetic.
+/// </summary>
+class Duration {
+private:
+    int64 _Nanos{ 0 };
+public:
+    _STD_API Duration() noexcept = default;
+    _STD_API explicit Duration(int64 nanos) noexcept
+        : _Nanos(nanos)
+    {}
+
+    _NODISCARD _STD_API static Duration from_nanos(int64 n) noexcept { return Duration(n); }
+    _NODISCARD _STD_API static Duration from_micros(int64 n) noexcept { return Duration(n * 1'000); }
+    _NODISCARD _STD_API static Duration from_millis(int64 n) noexcept { return Duration(n * 1'000'000); }
+    _NODISCARD _STD_API static Duration from_secs(int64 n) noexcept { return Duration(n * 1'000'000'000); }
+    _NODISCARD _STD_API static Duration zero() noexcept { return Duration(0); }
+
+    _NODISCARD _STD_API int64 as_nanos() const noexcept { return _Nanos; }
+    _NODISCARD _STD_API int64 as_micros() const noexcept { return _Nanos / 1'000; }
+    _NODISCARD _STD_API int64 as_millis() const noexcept { return _Nanos / 1'000'000; }
+    _NODISCARD _STD_API int64 as_secs() const noexcept { return _Nanos / 1'000'000'000; }
+    _NODISCARD _STD_API float64 as_secs_f64() const noexcept { return static_cast<float64>(_Nanos) / 1e9; }
+
+    _NODISCARD _STD_API bool is_zero() const noexcept { return _Nanos == 0; }
+
+    _STD_API Duration operator+(Duration other) const noexcept { return Duration(_Nanos + other._Nanos); }
+    _STD_API Duration operator-(Duration other) const noexcept { return Duration(_Nanos - other._Nanos); }
+    _STD_API Duration operator*(int64 factor) const noexcept { return Duration(_Nanos * factor); }
+    _STD_API Duration operator/(int64 divisor) const noexcept { return Duration(_Nanos / divisor); }
+    _STD_API int64 operator/(Duration other) const noexcept { return _Nanos / other._Nanos; }
+    _STD_API Duration operator-() const noexcept { return Duration(-_Nanos); }
+
+    _STD_API Duration& operator+=(Duration other) noexcept { _Nanos += other._Nanos; return *this; }
+    _STD_API Duration& operator-=(Duration other) noexcept { _Nanos -= other._Nanos; return *this; }
+
+    _STD_API auto operator<=>(const Duration&) const noexcept = default;
+
+    /// <summary>
+    /// Writes the duration in the largest unit that keeps it >= 1, with up to three decimals
+    /// (e.g "532ns", "1.250us", "12.003ms", "4.500s"). Returns the amount of characters written,
+    /// buffer should hold at least 32 bytes.
+    /// </summary>
+    inline size_t format_to(char* buffer, size_t length) const noexcept {
+        if (length == 0)
+            return 0;
+        // unsigned, -INT64_MIN does not fit in an int64.
+        const uint64 _Abs = _Nanos < 0 ? uint64{ 0 } - static_cast<uint64>(_Nanos) : static_cast<uint64>(_Nanos);
+        const char* _Sign = _Nanos < 0 ? "-" : "";
+
+        int _Written = 0;
+        if (_Abs < 1'000) {
+            _Written = std::snprintf(buffer, length, "%s%lluns", _Sign, static_cast<unsigned long long>(_Abs));
+        }
+        else {
+            uint64 _Scale = 1'000;
+            const char* _Unit = "us";
+            if (_Abs >= 1'000'000'000) {
+                _Scale = 1'000'000'000;
+                _Unit = "s";
+            }
+            else if (_Abs >= 1'000'000) {
+                _Scale = 1'000'000;
+                _Unit = "ms";
+            }
+            const auto _Whole = _Abs / _Scale;
+            const auto _Frac = (_Abs % _Scale) / (_Scale / 1'000);
+            _Written = std::snprintf(buffer, length, "%s%llu.%03llu%s",
+                _Sign, static_cast<unsigned long long>(_Whole), static_cast<unsigned long long>(_Frac), _Unit);
+        }
+        if (_Written < 0)
+            return 0;
+        return static_cast<size_t>(_Written) < length ? static_cast<size_t>(_Written) : length - 1;
+    }
+
+    inline std::string to_string() const noexcept {
+        char _Buffer[32];
+        return std::string(_Buffer, format_to(_Buffer, sizeof(_Buffer)));
+    }
+};
+
+/// <summary>
+/// A point on the monotonic clock. Only useful for measuring the time between two
+/// instants, it has no relation to the wall clock (see DateTime for that).
+///
+/// Linux reads CLOCK_MONOTONIC, which is served from the vDSO without entering the kernel.
+/// Windows reads QueryPerformanceCounter, with the frequency queried once.
+/// </summary>
+class Instant {
+private:
+    int64 _Nanos{ 0 };
+
+    _STD_API explicit Instant(int64 nanos) noexcept
+        : _Nanos(nanos)
+    {}
+
+#ifdef _WIN32
+    static inline int64 _Qpc_frequency() noexcept {
+        static const int64 _Frequency = []() {
+            LARGE_INTEGER _Freq = {};
+            QueryPerformanceFrequency(&_Freq);
+            return static_cast<int64>(_Freq.QuadPart);
+        }();
+        return _Frequency;
+    }
+#endif
+public:
+    _STD_API Instant() noexcept = default;
+
+    _NODISCARD static inline Instant now() noexcept {
+#ifdef _WIN32
+        LARGE_INTEGER _Counter = {};
+        QueryPerformanceCounter(&_Counter);
+        const auto _Freq = _Qpc_frequency();
+        // split to avoid overflowing when multiplying the raw counter by 1e9.
+        const auto _Whole = _Counter.QuadPart / _Freq;
+        const auto _Rem = _Counter.QuadPart % _Freq;
+        return Instant(_Whole * 1'000'000'000 + (_Rem * 1'000'000'000) / _Freq);
+#else
+        struct timespec _Ts;
+        clock_gettime(CLOCK_MONOTONIC, &_Ts);
+        return Instant(static_cast<int64>(_Ts.tv_sec) * 1'000'000'000 + _Ts.tv_nsec);
+#endif
+    }
+
+    // Time since this instant was taken.
+    _NODISCARD inline Duration elapsed() const noexcept {
+        return now() - *this;
+    }
+
+    // Nanoseconds since an unspecified (but fixed for the process) epoch.
+    _NODISCARD _STD_API int64 raw() const noexcept { return _Nanos; }
+
+    _STD_API Duration operator-(Instant earlier) const noexcept { return Duration(_Nanos - earlier._Nanos); }
+    _STD_API Instant operator+(Duration d) const noexcept { return Instant(_Nanos + d.as_nanos()); }
+    _STD_API Instant operator-(Duration d) const noexcept { return Instant(_Nanos - d.as_nanos()); }
+    _STD_API Instant& operator+=(Duration d) noexcept { _Nanos += d.as_nanos(); return *this; }
+    _STD_API Instant& operator-=(Duration d) noexcept { _Nanos -= d.as_nanos(); return *this; }
+
+    _STD_API auto operator<=>(const Instant&) const noexcept = default;
+};
+
+/// <summary>
+/// A wall clock that is read from memory instead of the OS.
+///
+/// A ticker thread samples the system clock every `resolution` and publishes both the
+/// unix time in milliseconds and a pre-formatted local timestamp ("YYYY-MM-DD HH:MM:SS.mmm").
+/// Readers never call into libc: unix_millis() is one atomic load, timestamp() copies the
+/// string out under a sequence lock. The offset comes from TimeZone::local(), re-read once per second.
+/// </summary>
+class CoarseClock {
+public:
+    static constexpr size_t TimestampLength = 23;
+private:
+    static constexpr size_t _Stamp_words = 3;
+
+    // Everything one tick publishes, read together under _Sequence.
+    struct _Tick_state {
+        int64 unix_millis;
+        int32 utc_offset;
+        uint64 stamp[_Stamp_words];
+    };
+
+    std::atomic<int64> _Unix_millis{ 0 };
+    std::atomic<int32> _Utc_offset{ 0 };
+    std::atomic<uint64> _Sequence{ 0 };
+    std::atomic<uint64> _Stamp[_Stamp_words]{};
+
+    Duration _Resolution;
+    int64 _Offset_second{ INT64_MIN };
+    std::atomic<bool> _Running{ false };
+    std::thread _Ticker;
+public:
+    _STD_MAKE_NONCOPYABLE(CoarseClock);
+    _STD_MAKE_NONMOVEABLE(CoarseClock);
+
+    inline explicit CoarseClock(Duration resolution = Duration::from_millis(1)) noexcept
+        : _Resolution(resolution)
+    {
+        _Tick();
+        _Running.store(true, std::memory_order_release);
+        _Ticker = std::thread([this]() {
+            while (_Running.load(std::memory_order_acquire)) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(_Resolution.as_nanos()));
+                _Tick();
+            }
+        });
+    }
+
+    inline ~CoarseClock() noexcept {
+        _Running.store(false, std::memory_order_release);
+        if (_Ticker.joinable())
+            _Ticker.join();
+    }
+
+    // The process wide clock, started on first use with millisecond resolution.
+    inline static CoarseClock& global() noexcept {
+        static CoarseClock _Clock;
+        return _Clock;
+    }
+
+    // Milliseconds since the unix epoch (UTC), as of the last tick.
+    _NODISCARD inline int64 unix_millis() const noexcept {
+        return _Unix_millis.load(std::memory_order_relaxed);
+    }
+
+    // Two calls to this and unix_millis() may see different ticks, now_local() does not.
+    _NODISCARD inline int32 utc_offset_seconds() const noexcept {
+        return _Utc_offset.load(std::memory_order_relaxed);
+    }
+
+    /// <summary>
+    /// Copy the local timestamp of the last tick into buffer (exactly TimestampLength bytes,
+    /// not null terminated).
+    /// </summary>
+    inline void timestamp(char* buffer) const noexcept {
+        const auto _State = _Load();
+        std::memcpy(buffer, _State.stamp, TimestampLength);
+    }
+
+    inline std::string timestamp() const noexcept {
+        char _Buffer[TimestampLength];
+        timestamp(_Buffer);
+        return std::string(_Buffer, TimestampLength);
+    }
+
+    // Local time of the last tick, its millis and offset always come from the same tick.
+    _NODISCARD inline DateTime now_local() const noexcept {
+        const auto _State = _Load();
+        return DateTime::from_unix_millis(_State.unix_millis, _State.utc_offset);
+    }
+    // UTC time of the last tick.
+    _NODISCARD inline DateTime now_utc() const noexcept {
+        return DateTime::from_unix_millis(unix_millis());
+    }
+
+private:
+    inline _Tick_state _Load() const noexcept {
+        _Tick_state _State;
+        uint64 _Before, _After;
+        do {
+            _Before = _Sequence.load(std::memory_order_acquire);
+            _State.unix_millis = _Unix_millis.load(std::memory_order_relaxed);
+            _State.utc_offset = _Utc_offset.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < _Stamp_words; ++i)
+                _State.stamp[i] = _Stamp[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            _After = _Sequence.load(std::memory_order_relaxed);
+        } while (_Before != _After || (_Before & 1));
+        return _State;
+    }
+
+    inline void _Tick() noexcept {
+        using namespace std::chrono;
+        const int64 _Now = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+
+        // only this thread stores the offset, so it can read back its own last value.
+        int32 _Offset = _Utc_offset.load(std::memory_order_relaxed);
+        const int64 _Second = _Now / 1000;
+        if (_Second != _Offset_second) {
+            _Offset_second = _Second;
+            _Offset = TimeZone::local().utc_offset_at(_Second);
+        }
+
+        const auto _Local = DateTime::from_unix_millis(_Now, _Offset);
+        char _Text[_Stamp_words * sizeof(uint64)] = {};
+        char* _Out = _DETAIL _Write_4_digits(_Text, _Local.year());
+        *_Out++ = '-';
+        _Out = _DETAIL _Write_2_digits(_Out, static_cast<size_t>(_Local.month()) + 1);
+        *_Out++ = '-';
+        _Out = _DETAIL _Write_2_digits(_Out, _Local.month_day());
+        *_Out++ = ' ';
+        _Out = _DETAIL _Write_2_digits(_Out, _Local.hours());
+        *_Out++ = ':';
+        _Out = _DETAIL _Write_2_digits(_Out, _Local.minutes());
+        *_Out++ = ':';
+        _Out = _DETAIL _Write_2_digits(_Out, _Local.seconds());
+        *_Out++ = '.';
+        _DETAIL _Write_3_digits(_Out, _Local.millis());
+
+        uint64 _Words[_Stamp_words];
+        std::memcpy(_Words, _Text, sizeof(_Words));
+
+        // single writer sequence lock: odd while the tick is being replaced.
+        const auto _Seq = _Sequence.load(std::memory_order_relaxed);
+        _Sequence.store(_Seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        _Unix_millis.store(_Now, std::memory_order_relaxed);
+        _Utc_offset.store(_Offset, std::memory_order_relaxed);
+        for (size_t i = 0; i < _Stamp_words; ++i)
+            _Stamp[i].store(_Words[i], std::memory_order_relaxed);
+        _Sequence.store(_Seq + 2, std::memory_order_release);
+    }
+};
+
+inline DateTime DateTime::now_coarse() noexcept {
+    return CoarseClock::global().now_local();
+}
+
 _STD_API_END
 
 #define _STUD_TIME
@@ -147,10 +147,9 @@ auto make_complex_version(size_t major, size_t minor, size_t others, std::string
 
 template <class T>
 _STD_API void swap(T& left, T& right) noexcept {
-    // Explicit type to force a copy.
-    T _Tmp = left;
-    left = _Tmp;
-    right = _Tmp;
+    T _Tmp = std::move(left);
+    left = std::move(right);
+    right = std::move(_Tmp);
 }
 
 template <class T, class U = T>
@@ -1,71 +1,171 @@
 
 #ifndef _STD_VECTOR_H
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
 #include <new>
+#include <type_traits>
 #include <initializer_list>
 #include <vector>
 
 #include "forward.hpp"
 #include "utility.hpp"
 #include "option.hpp"
+#include "panic.hpp"
+#include "format.hpp"
 
 _STD_API_BEGIN
 
-// FIXME: .at() returns garbage.
-
+/// <summary>
+/// A growable array. Elements are constructed in place and relocated with their move
+/// constructor when the buffer grows, trivially copyable ones with a plain realloc.
+/// </summary>
 template<class T>
 class Vector {
 public:
+    using value_type = T;
     using size_type = size_t;
     using pointer = T*;
-    using const_pointer = const pointer;
+    using const_pointer = const T*;
     using reference = T&;
     using const_reference = const T&;
+    using iterator = T*;
+    using const_iterator = const T*;
 private:
+    static_assert(alignof(T) <= alignof(std::max_align_t), "Vector storage comes from malloc, over-aligned types are not supported.");
+
     T* ptr_{ nullptr };
     size_t size_{ 0 };
     size_t cap_{ 0 };
 public:
     _STD_API Vector() = default;
     _STD_API Vector(std::initializer_list<T> elems) noexcept {
-        for (const auto element : elems) {
+        reserve(elems.size());
+        for (const auto& element : elems) {
             push_back(element);
         }
     }
 
     _STD_API Vector(const Vector& other) noexcept {
-        T* _Ptr = other.data();
+        reserve(other.size());
         for (size_type offset = 0; offset < other.size(); ++offset) {
-            this->push_back(*(_Ptr + offset));
+            ::new (static_cast<void*>(ptr_ + offset)) T(other.ptr_[offset]);
         }
+        size_ = other.size_;
     }
-    _STD_API Vector(Vector&& other) {
-        auto* _Elems = other.drain();
+    _STD_API Vector(Vector&& other) noexcept {
         cap_ = other.cap_;
         size_ = other.size_;
-        ptr_ = _Elems;
+        ptr_ = other.drain();
+    }
+
+    _STD_API Vector& operator=(const Vector& other) noexcept {
+        if (this != &other) {
+            Vector _Copy(other);
+            swap(_Copy);
+        }
+        return *this;
+    }
+    _STD_API Vector& operator=(Vector&& other) noexcept {
+        if (this != &other) {
+            clear();
+            if (ptr_) ::free(ptr_);
+            cap_ = other.cap_;
+            size_ = other.size_;
+            ptr_ = other.drain();
+        }
+        return *this;
     }
 
     _STD_API ~Vector() noexcept {
+        clear();
         if (ptr_) ::free(ptr_);
     }
 
+    _STD_API void swap(Vector& other) noexcept {
+        std::swap(ptr_, other.ptr_);
+        std::swap(size_, other.size_);
+        std::swap(cap_, other.cap_);
+    }
+    friend _STD_API void swap(Vector& left, Vector& right) noexcept {
+        left.swap(right);
+    }
+
     _STD_API void push_back(const T& element) noexcept {
-        _Verify_state();
-        ptr_[size_] = element;
-        size_++;
+        emplace_back(element);
+    }
+    _STD_API void push_back(T&& element) noexcept {
+        emplace_back(std::move(element));
     }
     template<typename... Ts>
-    _STD_API void emplace_back(Ts&&... args) noexcept {
-        this->push_back(T{ std::forward<Ts>(args)... });
+    _STD_API reference emplace_back(Ts&&... args) noexcept {
+        if (size_ == cap_) [[unlikely]] {
+            // the arguments may refer into our own buffer, build the element before it moves.
+            T _Element(std::forward<Ts>(args)...);
+            _Grow(size_ + 1);
+            ::new (static_cast<void*>(ptr_ + size_)) T(std::move(_Element));
+            return ptr_[size_++];
+        }
+        auto* _Element = ::new (static_cast<void*>(ptr_ + size_)) T(std::forward<Ts>(args)...);
+        size_++;
+        return *_Element;
+    }
+
+    _STD_API void pop_back() noexcept {
+        panic(IF(size_ == 0), "cannot pop_back() from an empty vector.");
+        --size_;
+        ptr_[size_].~T();
+    }
+
+    // Insert before `where`, shifting everything after it up by one.
+    _STD_API iterator insert(const_iterator where, T element) noexcept {
+        const size_type _Offset = static_cast<size_type>(where - ptr_);
+        panic(IF(_Offset > size_), "cannot insert into vector at a position greater than the vectors size.");
+        emplace_back(std::move(element));
+        std::rotate(ptr_ + _Offset, ptr_ + size_ - 1, ptr_ + size_);
+        return ptr_ + _Offset;
+    }
+
+    // Remove [first, last), shifting the tail down.
+    _STD_API iterator erase(const_iterator first, const_iterator last) noexcept {
+        auto* _First = ptr_ + (first - ptr_);
+        auto* _Last = ptr_ + (last - ptr_);
+        if (_First != _Last) {
+            auto* _New_end = std::move(_Last, ptr_ + size_, _First);
+            std::destroy(_New_end, ptr_ + size_);
+            size_ = static_cast<size_type>(_New_end - ptr_);
+        }
+        return _First;
+    }
+    _STD_API iterator erase(const_iterator where) noexcept {
+        return erase(where, where + 1);
     }
 
     _STD_API reference at(size_type offset) noexcept {
-        panic(IF(offset > size()), "cannot offset into vector at a position greater than the vectors size.");
+        panic(IF(offset >= size()), "cannot offset into vector at a position greater than the vectors size.");
         return ptr_[offset];
     }
+    _STD_API const_reference at(size_type offset) const noexcept {
+        panic(IF(offset >= size()), "cannot offset into vector at a position greater than the vectors size.");
+        return ptr_[offset];
+    }
+
+    // Unchecked.
+    _STD_API reference operator[](size_type offset) noexcept {
+        return ptr_[offset];
+    }
+    _STD_API const_reference operator[](size_type offset) const noexcept {
+        return ptr_[offset];
+    }
+
+    _STD_API reference front() noexcept { return at(0); }
+    _STD_API const_reference front() const noexcept { return at(0); }
+    _STD_API reference back() noexcept { return at(size_ - 1); }
+    _STD_API const_reference back() const noexcept { return at(size_ - 1); }
 
-    // transfer ownership of the internal data to the caller.
+    // transfer ownership of the internal data to the caller (allocated with ::malloc).
     _STD_API T* drain() noexcept {
         auto* _Copy = ptr_;
         ptr_ = nullptr;
@@ -74,12 +174,33 @@ public:
         return _Copy;
     }
 
+    _STD_API void reserve(size_type count) noexcept {
+        if (count > cap_)
+            _Reallocate(count);
+    }
+
+    _STD_API void resize(size_type count) noexcept {
+        _Resize(count);
+    }
+    _STD_API void resize(size_type count, const T& value) noexcept {
+        _Resize(count, value);
+    }
+
+    // Destroys every element, the capacity is kept.
+    _STD_API void clear() noexcept {
+        std::destroy(ptr_, ptr_ + size_);
+        size_ = 0;
+    }
+
     _STD_API size_type size() const noexcept {
         return size_;
     }
     _STD_API size_type capacity() const noexcept {
         return cap_;
     }
+    _STD_API bool empty() const noexcept {
+        return size_ == 0;
+    }
 
     _STD_API pointer data() noexcept {
         return ptr_;
@@ -87,33 +208,264 @@ public:
     _STD_API const_pointer data() const noexcept {
         return ptr_;
     }
+
+    _STD_API iterator begin() noexcept { return ptr_; }
+    _STD_API iterator end() noexcept { return ptr_ + size_; }
+    _STD_API const_iterator begin() const noexcept { return ptr_; }
+    _STD_API const_iterator end() const noexcept { return ptr_ + size_; }
 private:
-    _STD_API void _Verify_state() noexcept {
-        if (!cap_) {
-            // we are not yet initialized, we should allocate
-            // some memory.
-            ptr_ = static_cast<pointer>(::malloc(sizeof(T) * 2));
-            cap_ = 2;
+    template <class... Args>
+    _STD_API void _Resize(size_type count, const Args&... value) noexcept {
+        if (count < size_) {
+            std::destroy(ptr_ + count, ptr_ + size_);
+            size_ = count;
             return;
         }
-        if (cap_ == size_) {
-            // double in size.
-            auto* _Old = ptr_;
-            ptr_ = static_cast<pointer>(::malloc(cap_ * 2));
-            cap_ = cap_ * 2;
-            if (!ptr_) {
-                ptr_ = static_cast<pointer>(::malloc(sizeof(T) * 2));
-                cap_ = 2;
-                return;
-            }
-            std::memcpy(ptr_, _Old, size_);
-            ::free(_Old);
+        reserve(count);
+        for (; size_ < count; ++size_)
+            ::new (static_cast<void*>(ptr_ + size_)) T(value...);
+    }
+
+    _STD_API void _Grow(size_type minimum) noexcept {
+        size_type _New_cap = cap_ ? cap_ * 2 : 2;
+        if (_New_cap < minimum)
+            _New_cap = minimum;
+        _Reallocate(_New_cap);
+    }
+
+    _STD_API void _Reallocate(size_type new_cap) noexcept {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            auto* _New = static_cast<pointer>(::realloc(ptr_, sizeof(T) * new_cap));
+            panic(IF(_New == nullptr), "Vector: out of memory (requested {} elements)", new_cap);
+            ptr_ = _New;
+        }
+        else {
+            auto* _New = static_cast<pointer>(::malloc(sizeof(T) * new_cap));
+            panic(IF(_New == nullptr), "Vector: out of memory (requested {} elements)", new_cap);
+            std::uninitialized_move(ptr_, ptr_ + size_, _New);
+            std::destroy(ptr_, ptr_ + size_);
+            if (ptr_) ::free(ptr_);
+            ptr_ = _New;
+        }
+        cap_ = new_cap;
+    }
+};
+
+/// <summary>
+/// A Vector with its capacity fixed at N and its storage inline: no heap allocation, ever.
+/// Slots stay uninitialized until pushed, so N can be generous for types that are expensive
+/// to construct. Everything is constexpr, and for trivially copyable T the StaticVector
+/// is trivially copyable too. Pushing past N panics; try_push_back() reports it instead.
+/// </summary>
+template<class T, size_t N>
+class StaticVector {
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using iterator = T*;
+    using const_iterator = const T*;
+private:
+    // a union member is not constructed until an element is, so slots start out raw.
+    union {
+        T elems_[N];
+    };
+    size_t size_{ 0 };
+public:
+    _STD_API StaticVector() noexcept {}
+    _STD_API StaticVector(std::initializer_list<T> elems) noexcept {
+        panic(IF(elems.size() > N), "cannot initialize a StaticVector<T, {}> with {} elements.", N, elems.size());
+        for (const auto& element : elems)
+            std::construct_at(elems_ + size_++, element);
+    }
+
+    StaticVector(const StaticVector&) requires std::is_trivially_copyable_v<T> = default;
+    _STD_API StaticVector(const StaticVector& other) noexcept {
+        for (; size_ < other.size_; ++size_)
+            std::construct_at(elems_ + size_, other.elems_[size_]);
+    }
+    StaticVector(StaticVector&&) requires std::is_trivially_copyable_v<T> = default;
+    _STD_API StaticVector(StaticVector&& other) noexcept {
+        for (; size_ < other.size_; ++size_)
+            std::construct_at(elems_ + size_, std::move(other.elems_[size_]));
+        other.clear();
+    }
+
+    StaticVector& operator=(const StaticVector&) requires std::is_trivially_copyable_v<T> = default;
+    _STD_API StaticVector& operator=(const StaticVector& other) noexcept {
+        if (this != &other) {
+            clear();
+            for (; size_ < other.size_; ++size_)
+                std::construct_at(elems_ + size_, other.elems_[size_]);
+        }
+        return *this;
+    }
+    StaticVector& operator=(StaticVector&&) requires std::is_trivially_copyable_v<T> = default;
+    _STD_API StaticVector& operator=(StaticVector&& other) noexcept {
+        if (this != &other) {
+            clear();
+            for (; size_ < other.size_; ++size_)
+                std::construct_at(elems_ + size_, std::move(other.elems_[size_]));
+            other.clear();
+        }
+        return *this;
+    }
+
+    ~StaticVector() requires std::is_trivially_destructible_v<T> = default;
+    _STD_API ~StaticVector() noexcept {
+        clear();
+    }
+
+    _STD_API void push_back(const T& element) noexcept {
+        emplace_back(element);
+    }
+    _STD_API void push_back(T&& element) noexcept {
+        emplace_back(std::move(element));
+    }
+    template<typename... Ts>
+    _STD_API reference emplace_back(Ts&&... args) noexcept {
+        panic(IF(size_ >= N), "StaticVector: capacity of {} exceeded.", N);
+        return *std::construct_at(elems_ + size_++, std::forward<Ts>(args)...);
+    }
+
+    // nullptr, and nothing constructed, when the vector is full.
+    template<typename... Ts>
+    _NODISCARD _STD_API pointer try_emplace_back(Ts&&... args) noexcept {
+        if (size_ == N)
+            return nullptr;
+        return std::construct_at(elems_ + size_++, std::forward<Ts>(args)...);
+    }
+    _NODISCARD _STD_API pointer try_push_back(T element) noexcept {
+        return try_emplace_back(std::move(element));
+    }
+
+    _STD_API void pop_back() noexcept {
+        panic(IF(size_ == 0), "cannot pop_back() from an empty StaticVector.");
+        std::destroy_at(elems_ + --size_);
+    }
+
+    // Insert before `where`, shifting everything after it up by one.
+    _STD_API iterator insert(const_iterator where, T element) noexcept {
+        const size_type _Offset = static_cast<size_type>(where - elems_);
+        panic(IF(_Offset > size_), "cannot insert into StaticVector at a position greater than its size.");
+        emplace_back(std::move(element));
+        std::rotate(elems_ + _Offset, elems_ + size_ - 1, elems_ + size_);
+        return elems_ + _Offset;
+    }
+
+    // Remove [first, last), shifting the tail down.
+    _STD_API iterator erase(const_iterator first, const_iterator last) noexcept {
+        auto* _First = elems_ + (first - elems_);
+        auto* _Last = elems_ + (last - elems_);
+        if (_First != _Last) {
+            auto* _New_end = std::move(_Last, elems_ + size_, _First);
+            std::destroy(_New_end, elems_ + size_);
+            size_ = static_cast<size_type>(_New_end - elems_);
+        }
+        return _First;
+    }
+    _STD_API iterator erase(const_iterator where) noexcept {
+        return erase(where, where + 1);
+    }
+
+    _STD_API reference at(size_type offset) noexcept {
+        panic(IF(offset >= size_), "cannot offset into StaticVector at a position greater than its size.");
+        return elems_[offset];
+    }
+    _STD_API const_reference at(size_type offset) const noexcept {
+        panic(IF(offset >= size_), "cannot offset into StaticVector at a position greater than its size.");
+        return elems_[offset];
+    }
+
+    // Unchecked.
+    _STD_API reference operator[](size_type offset) noexcept {
+        return elems_[offset];
+    }
+    _STD_API const_reference operator[](size_type offset) const noexcept {
+        return elems_[offset];
+    }
+
+    _STD_API reference front() noexcept { return at(0); }
+    _STD_API const_reference front() const noexcept { return at(0); }
+    _STD_API reference back() noexcept { return at(size_ - 1); }
+    _STD_API const_reference back() const noexcept { return at(size_ - 1); }
+
+    _STD_API void resize(size_type count) noexcept {
+        _Resize(count);
+    }
+    _STD_API void resize(size_type count, const T& value) noexcept {
+        _Resize(count, value);
+    }
+
+    _STD_API void clear() noexcept {
+        std::destroy(elems_, elems_ + size_);
+        size_ = 0;
+    }
+
+    _STD_API size_type size() const noexcept {
+        return size_;
+    }
+    static _STD_API size_type capacity() noexcept {
+        return N;
+    }
+    _STD_API bool empty() const noexcept {
+        return size_ == 0;
+    }
+    _STD_API bool full() const noexcept {
+        return size_ == N;
+    }
+
+    _STD_API pointer data() noexcept {
+        return elems_;
+    }
+    _STD_API const_pointer data() const noexcept {
+        return elems_;
+    }
+
+    _STD_API iterator begin() noexcept { return elems_; }
+    _STD_API iterator end() noexcept { return elems_ + size_; }
+    _STD_API const_iterator begin() const noexcept { return elems_; }
+    _STD_API const_iterator end() const noexcept { return elems_ + size_; }
+private:
+    template <class... Args>
+    _STD_API void _Resize(size_type count, const Args&... value) noexcept {
+        panic(IF(count > N), "StaticVector: cannot resize to {}, the capacity is {}.", count, N);
+        if (count < size_) {
+            std::destroy(elems_ + count, elems_ + size_);
+            size_ = count;
             return;
         }
+        for (; size_ < count; ++size_)
+            std::construct_at(elems_ + size_, value...);
     }
 };
 
 _STD_API_END
 
+namespace std {
+
+template <class T>
+    requires stud::__detail::_Formattable_element<T>
+struct formatter<stud::Vector<T>, char> : stud::__detail::_Sequence_formatter<T> {
+    template <class FormatContext>
+    auto format(const stud::Vector<T>& vector, FormatContext& ctx) const {
+        return this->_Format(vector.begin(), vector.end(), ctx);
+    }
+};
+
+template <class T, size_t N>
+    requires stud::__detail::_Formattable_element<T>
+struct formatter<stud::StaticVector<T, N>, char> : stud::__detail::_Sequence_formatter<T> {
+    template <class FormatContext>
+    auto format(const stud::StaticVector<T, N>& vector, FormatContext& ctx) const {
+        return this->_Format(vector.begin(), vector.end(), ctx);
+    }
+};
+
+} // namespace std
+
 #define _STD_VECTOR_H
 #endif
\ No newline at end of file